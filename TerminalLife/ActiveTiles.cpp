@@ -0,0 +1,84 @@
+﻿#include "pch.h"
+#include "ActiveTiles.h"
+
+ActiveTiles::ActiveTiles(int columns, int rows)
+	: _columns(columns), _rows(rows)
+{
+	_changed.resize(static_cast<size_t>(_columns) * _rows, 0);
+	_active.resize(_changed.size(), 0);
+	_activeCount = static_cast<int>(_active.size());
+	_computed = _activeCount;
+}
+
+void ActiveTiles::MarkAllActive()
+{
+	_all = true;
+	_activeCount = static_cast<int>(_active.size());
+}
+
+void ActiveTiles::Wake(int tx, int ty)
+{
+	if (_all)
+	{
+		return;
+	}
+
+	for (const int column : { (tx == 0) ? _columns - 1 : tx - 1, tx, (tx == _columns - 1) ? 0 : tx + 1 })
+	{
+		uint8_t& active = _active[column + (ty * _columns)];
+		_activeCount += !active;
+		active = 1;
+	}
+}
+
+void ActiveTiles::Update()
+{
+	_computed = _activeCount;
+	_activeCount = 0;
+	_all = false;
+
+	for (int ty = 0; ty < _rows; ty++)
+	{
+		const int above = (ty == 0) ? _rows - 1 : ty - 1;
+		const int below = (ty == _rows - 1) ? 0 : ty + 1;
+
+		for (int tx = 0; tx < _columns; tx++)
+		{
+			const int left = (tx == 0) ? _columns - 1 : tx - 1;
+			const int right = (tx == _columns - 1) ? 0 : tx + 1;
+
+			uint8_t active = 0;
+			for (const int row : { above, ty, below })
+			{
+				const uint8_t* changed = &_changed[static_cast<size_t>(row) * _columns];
+				active |= changed[left] | changed[tx] | changed[right];
+			}
+
+			_active[tx + (ty * _columns)] = active;
+			_activeCount += active;
+		}
+	}
+
+	if (_twisted)
+	{
+		const auto any = [this](int ty)
+		{
+			const auto row = _changed.begin() + (static_cast<size_t>(ty) * _columns);
+			return std::find(row, row + _columns, uint8_t{ 1 }) != row + _columns;
+		};
+
+		const bool wakeTop = any(_rows - 1);
+		const bool wakeBottom = any(0);
+		for (const auto& [ty, wake] : { std::pair{ 0, wakeTop }, std::pair{ _rows - 1, wakeBottom } })
+		{
+			for (int tx = 0; wake && tx < _columns; tx++)
+			{
+				uint8_t& active = _active[tx + (ty * _columns)];
+				_activeCount += !active;
+				active = 1;
+			}
+		}
+	}
+
+	std::fill(_changed.begin(), _changed.end(), uint8_t{ 0 });
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+
+// keeps track of which tiles of a board changed in the last step. a cell can only change if something
+// in its neighborhood did, so a tile only needs computing if it or one of its eight neighbors changed,
+// everything else is dead space or still lifes and gets skipped. tiles wrap around like a torus, which is
+// just a little too eager for the other topologies, except for the Klein bottle's mirrored top and bottom
+class ActiveTiles
+{
+public:
+    // rows per tile, and columns too for the Cells engine
+    static constexpr int Size = 32;
+
+private:
+    int _columns = 0;
+    int _rows = 0;
+    std::vector<uint8_t> _changed;
+    std::vector<uint8_t> _active;
+    int _activeCount = 0;
+    int _computed = 0;
+    // set by MarkAllActive so that writing a lot of cells one at a time stays cheap
+    bool _all = true;
+    // the top and bottom rows join mirrored, see SetTwisted
+    bool _twisted = false;
+
+public:
+    ActiveTiles() = default;
+    ActiveTiles(int columns, int rows);
+
+    int Columns() const
+    {
+        return _columns;
+    }
+
+    int Rows() const
+    {
+        return _rows;
+    }
+
+    bool IsActive(int tx, int ty) const
+    {
+        return _all || _active[tx + (ty * _columns)] != 0;
+    }
+
+    // only ever called by the band that owns tile row ty
+    void MarkChanged(int tx, int ty)
+    {
+        _changed[tx + (ty * _columns)] = 1;
+    }
+
+    // after anything other than a step touches the board, or the rule changes
+    void MarkAllActive();
+
+    // something past the edge of the board changed next to tile (tx, ty), for a board that's one piece of a bigger one
+    // the tile and the ones either side of it get computed in the coming step
+    void Wake(int tx, int ty);
+
+    // the top and bottom tile rows meet mirrored, like a Klein bottle. mirrored tiles don't line up
+    // unless the width is a whole number of tiles, so a change in either row wakes all of the other
+    void SetTwisted(bool twisted)
+    {
+        _twisted = twisted;
+        MarkAllActive();
+    }
+
+    // works out which tiles the next step has to compute and clears the changed flags
+    void Update();
+
+    // the fraction of tiles the last step actually computed
+    double ActiveRatio() const
+    {
+        return _active.empty() ? 1.0 : static_cast<double>(_computed) / static_cast<double>(_active.size());
+    }
+};
@@ -0,0 +1,737 @@
+﻿#include "pch.h"
+#include "Benchmark.h"
+#include "PatternFile.h"
+#include "Checkpoint.h"
+#include "Profiler.h"
+#include "CacheSizes.h"
+
+namespace
+{
+	bool ParseNumber(std::string_view text, auto& value)
+	{
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		return error == std::errc() && end == text.data() + text.size();
+	}
+
+	// 1024x768, or just 1024 for a square
+	bool ParseSize(std::string_view text, int& width, int& height)
+	{
+		const size_t x = text.find('x');
+		if (x == std::string_view::npos)
+		{
+			return ParseNumber(text, width) && ParseNumber(text, height);
+		}
+		return ParseNumber(text.substr(0, x), width) && ParseNumber(text.substr(x + 1), height);
+	}
+
+	// 10,20
+	bool ParsePoint(std::string_view text, int& x, int& y)
+	{
+		const size_t comma = text.find(',');
+		return comma != std::string_view::npos && ParseNumber(text.substr(0, comma), x) && ParseNumber(text.substr(comma + 1), y);
+	}
+
+	bool ParseEngine(std::string_view text, Board::Engine& engine)
+	{
+		constexpr std::pair<std::string_view, Board::Engine> engines[] =
+		{
+			{ "cells", Board::Engine::Cells },
+			{ "packed", Board::Engine::Packed },
+			{ "hashlife", Board::Engine::HashLife },
+			{ "incremental", Board::Engine::Incremental },
+			{ "sparse", Board::Engine::Sparse },
+		};
+
+		for (const auto& [name, value] : engines)
+		{
+			if (text == name)
+			{
+				engine = value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	constexpr std::pair<std::string_view, Topology> topologies[] =
+	{
+		{ "torus", Topology::Torus },
+		{ "bounded", Topology::Bounded },
+		{ "cylinder", Topology::Cylinder },
+		{ "klein", Topology::Klein },
+	};
+
+	bool ParseTopology(std::string_view text, Topology& topology)
+	{
+		for (const auto& [name, value] : topologies)
+		{
+			if (text == name)
+			{
+				topology = value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string_view TopologyName(Topology topology)
+	{
+		for (const auto& [name, value] : topologies)
+		{
+			if (topology == value)
+			{
+				return name;
+			}
+		}
+		return "unknown";
+	}
+
+	// the HashLife and Sparse planes don't have edges for a topology to join up
+	std::string_view EdgesName(Board::Engine engine, Topology topology)
+	{
+		return (engine == Board::Engine::HashLife || engine == Board::Engine::Sparse) ? "plane" : TopologyName(topology);
+	}
+
+	bool ParseKernel(std::string_view text, std::optional<ByteKernel::Level>& kernel)
+	{
+		for (const ByteKernel::Level level : { ByteKernel::Level::Scalar, ByteKernel::Level::Sse41, ByteKernel::Level::Avx2 })
+		{
+			if (text == ByteKernel::Name(level))
+			{
+				kernel = level;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string_view EngineName(Board::Engine engine)
+	{
+		switch (engine)
+		{
+		case Board::Engine::Cells: return "cells";
+		case Board::Engine::Packed: return "packed";
+		case Board::Engine::HashLife: return "hashlife";
+		case Board::Engine::Incremental: return "incremental";
+		case Board::Engine::Sparse: return "sparse";
+		}
+		return "unknown";
+	}
+
+	// the rule on the command line wins, but say so
+	void CheckRule(std::string_view source, std::string_view rule, const Benchmark::Options& options)
+	{
+		if (rule.empty())
+		{
+			return;
+		}
+
+		const std::optional<Rule> parsed = Rule::Parse(rule);
+		if (!parsed || parsed->ToString() != Rule::Parse(options.rule)->ToString())
+		{
+			std::cout << "TerminalLife: " << source << " is for " << rule << ", running " << options.rule << std::endl;
+		}
+	}
+
+	// what the board started from, for the report
+	std::string Source(const Benchmark::Options& options)
+	{
+		if (!options.restore.empty())
+		{
+			return options.restore;
+		}
+		if (!options.load.empty())
+		{
+			return options.load;
+		}
+		return options.pattern.empty() ? "density " + std::to_string(options.density) : options.pattern;
+	}
+
+	double Percentile(std::vector<double>& values, double fraction)
+	{
+		if (values.empty())
+		{
+			return 0.0;
+		}
+
+		const size_t n = std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+		std::nth_element(values.begin(), values.begin() + n, values.end());
+		return values[n];
+	}
+}
+
+bool Benchmark::Requested(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string_view(argv[i]) == "--bench")
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+std::optional<Benchmark::Options> Benchmark::Parse(int argc, char* argv[])
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg(argv[i]);
+		if (arg == "--bench")
+		{
+			continue;
+		}
+		if (arg == "--until-stable")
+		{
+			options.untilStable = true;
+			continue;
+		}
+		if (arg == "--sweep")
+		{
+			options.sweep = true;
+			continue;
+		}
+
+		// everything else takes a value
+		if (i + 1 >= argc)
+		{
+			return std::nullopt;
+		}
+		const std::string_view value(argv[++i]);
+
+		bool ok = false;
+		if (arg == "--size")
+		{
+			ok = ParseSize(value, options.width, options.height) && options.width > 0 && options.height > 0;
+		}
+		else if (arg == "--rule")
+		{
+			options.rule = value;
+			ok = Rule::Parse(value).has_value();
+		}
+		else if (arg == "--seed")
+		{
+			ok = ParseNumber(value, options.seed);
+		}
+		else if (arg == "--density")
+		{
+			ok = ParseNumber(value, options.density) && options.density >= 0.0 && options.density <= 1.0;
+		}
+		else if (arg == "--generations")
+		{
+			ok = ParseNumber(value, options.generations) && options.generations > 0;
+		}
+		else if (arg == "--engine")
+		{
+			ok = ParseEngine(value, options.engine);
+		}
+		else if (arg == "--compare")
+		{
+			ok = ParseEngine(value, options.compare.emplace());
+		}
+		else if (arg == "--block")
+		{
+			ok = ParseSize(value, options.blockWidth, options.blockHeight) && options.blockWidth >= 0 && options.blockHeight >= 0;
+		}
+		else if (arg == "--topology")
+		{
+			ok = ParseTopology(value, options.topology);
+		}
+		else if (arg == "--threads")
+		{
+			ok = ParseNumber(value, options.threads) && options.threads > 0;
+		}
+		else if (arg == "--processes")
+		{
+			ok = ParseNumber(value, options.processes) && options.processes > 0 && options.processes <= Stripes::MaxProcesses;
+		}
+		else if (arg == "--pattern")
+		{
+			options.pattern = value;
+			ok = Patterns::Find(value) != nullptr;
+		}
+		else if (arg == "--load" || arg == "--save" || arg == "--history")
+		{
+			(arg == "--load" ? options.load : arg == "--save" ? options.save : options.history) = value;
+			ok = !value.empty();
+		}
+		else if (arg == "--trace")
+		{
+			options.trace = value;
+			ok = !value.empty();
+		}
+		else if (arg == "--restore" || arg == "--checkpoint")
+		{
+			(arg == "--restore" ? options.restore : options.checkpoint) = value;
+			ok = !value.empty();
+		}
+		else if (arg == "--every")
+		{
+			ok = ParseNumber(value, options.checkpointEvery) && options.checkpointEvery > 0;
+		}
+		else if (arg == "--at")
+		{
+			ok = ParsePoint(value, options.atX, options.atY);
+		}
+		else if (arg == "--kernel")
+		{
+			ok = ParseKernel(value, options.kernel);
+		}
+		else if (arg == "--step")
+		{
+			ok = ParseNumber(value, options.step) && options.step >= 0 && options.step < 62;
+		}
+		else if (arg == "--jump")
+		{
+			ok = ParseNumber(value, options.jump) && options.jump > 0;
+		}
+
+		if (!ok)
+		{
+			std::cout << "TerminalLife: bad value for " << arg << ": " << value << std::endl;
+			return std::nullopt;
+		}
+	}
+
+	// the checkpoint decides the size
+	if (!options.restore.empty())
+	{
+		const std::optional<Checkpoint::Header> header = Checkpoint::ReadHeader(options.restore);
+		if (!header)
+		{
+			std::cout << "TerminalLife: " << options.restore << " isn't a checkpoint" << std::endl;
+			return std::nullopt;
+		}
+		options.width = header->width;
+		options.height = header->height;
+	}
+
+	// the stripes only start from a random fill, and the cells never leave the workers
+	if (options.processes > 1 && !(options.pattern.empty() && options.load.empty() && options.restore.empty() && options.save.empty()
+		&& options.checkpoint.empty() && options.history.empty() && options.trace.empty() && !options.compare && options.jump == 0))
+	{
+		std::cout << "TerminalLife: --processes only runs random fills, without --pattern, --load, --restore, --save, --checkpoint, --history, --trace, --compare or --jump" << std::endl;
+		return std::nullopt;
+	}
+
+	// only the tree can skip generations, and the board it's compared against has to skip the same ones
+	if (options.jump > 0 && (options.engine != Board::Engine::HashLife || options.compare.value_or(Board::Engine::HashLife) != Board::Engine::HashLife))
+	{
+		std::cout << "TerminalLife: --jump only works with the hashlife engine" << std::endl;
+		return std::nullopt;
+	}
+
+	return options;
+}
+
+void Benchmark::PrintUsage()
+{
+	std::cout << "usage: TerminalLife --bench [--size 1024x1024] [--rule B3/S23] [--seed 1] [--density 0.25]\n"
+		"                     [--generations 1000] [--engine cells|packed|hashlife|incremental|sparse] [--threads n] [--step log2]\n"
+		"                     [--topology torus|bounded|cylinder|klein] [--block 0x0] [--sweep] [--processes n]\n"
+		"                     [--kernel scalar|sse4.1|avx2] [--until-stable] [--history file.csv] [--trace file.json]\n"
+		"                     [--pattern glider|lwss|r-pentomino|diehard|acorn|gosper-gun] [--load file.rle [--at x,y]] [--save file.rle]\n"
+		"                     [--restore file.tlc] [--checkpoint file.tlc [--every 10000]] [--compare engine] [--jump n]\n"
+		"without --bench the same options pick the board for an interactive run, --save writes the board on the way out" << std::endl;
+}
+
+bool Benchmark::Seed(Board& board, const Options& options)
+{
+	board.SetTopology(options.topology);
+	if (board.GetTopology() != options.topology)
+	{
+		std::cout << "TerminalLife: the " << EngineName(options.engine) << " engine runs on an unbounded plane, ignoring --topology" << std::endl;
+	}
+
+	if (!options.restore.empty())
+	{
+		const std::optional<Checkpoint::Header> header = Checkpoint::Restore(options.restore, board);
+		if (!header)
+		{
+			std::cout << "TerminalLife: couldn't restore " << options.restore << std::endl;
+			return false;
+		}
+
+		CheckRule(options.restore, header->rule, options);
+		return true;
+	}
+
+	if (!options.load.empty())
+	{
+		board.Fill(0.0, options.seed);
+
+		std::ifstream file(options.load, std::ios::binary);
+		const std::optional<PatternFile::Info> info = file ? PatternFile::Load(file, board, options.atX, options.atY) : std::nullopt;
+		if (!info)
+		{
+			std::cout << "TerminalLife: couldn't read a pattern from " << options.load << std::endl;
+			return false;
+		}
+
+		CheckRule(options.load, info->rule, options);
+		return true;
+	}
+
+	const Pattern* pattern = options.pattern.empty() ? nullptr : Patterns::Find(options.pattern);
+	if (!pattern)
+	{
+		board.Fill(options.density, options.seed);
+		return true;
+	}
+
+	board.Fill(0.0, options.seed);
+	board.Place(*pattern, board.Width() / 2, board.Height() / 2);
+	return true;
+}
+
+size_t Benchmark::HistoryLength(const Options& options)
+{
+	// the whole run, within reason
+	constexpr int64_t most = 1 << 20;
+	return options.history.empty() ? 0 : static_cast<size_t>(std::min(options.generations, most));
+}
+
+bool Benchmark::Save(const Board& board, std::string_view rule, const Options& options)
+{
+	if (!options.save.empty())
+	{
+		std::ofstream file(options.save, std::ios::binary);
+		PatternFile::Save(file, board, rule);
+		if (!file)
+		{
+			std::cout << "TerminalLife: couldn't write " << options.save << std::endl;
+			return false;
+		}
+	}
+
+	if (!options.history.empty())
+	{
+		std::ofstream file(options.history, std::ios::binary);
+		board.GetHistory().WriteCsv(file);
+		if (!file)
+		{
+			std::cout << "TerminalLife: couldn't write " << options.history << std::endl;
+			return false;
+		}
+	}
+
+	if (!options.trace.empty() && !Profiler::WriteTrace(options.trace))
+	{
+		std::cout << "TerminalLife: couldn't write " << options.trace << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int Benchmark::Run(const Options& options)
+{
+	if (options.processes > 1)
+	{
+		return RunStriped(options);
+	}
+
+	const Rule rule = *Rule::Parse(options.rule);
+	for (const Board::Engine engine : { options.engine, options.compare.value_or(options.engine) })
+	{
+		if (engine != Board::Engine::Cells && engine != Board::Engine::Incremental && !rule.IsPlain())
+		{
+			std::cout << "TerminalLife: the " << EngineName(engine) << " engine only runs plain B/S rules" << std::endl;
+			return -1;
+		}
+	}
+
+	if (options.kernel)
+	{
+		ByteKernel::Force(*options.kernel);
+	}
+
+	if (options.sweep)
+	{
+		return Sweep(options);
+	}
+
+	Board board(options.width, options.height, options.engine);
+	board.SetThreads(options.threads);
+	board.SetBlockSize(options.blockWidth, options.blockHeight);
+	board.SetStepSize(options.step);
+	board.KeepHistory(HistoryLength(options));
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point seeding = Clock::now();
+	if (!Seed(board, options))
+	{
+		return -1;
+	}
+	const double seeded = std::chrono::duration<double, std::milli>(Clock::now() - seeding).count();
+
+	std::cout << "engine " << EngineName(options.engine) << ", " << options.width << "x" << options.height << " " << EdgesName(options.engine, board.GetTopology()) << ", " << rule.ToString()
+		<< ", seed " << options.seed << ", " << Source(options)
+		<< ", " << board.Threads() << " threads, " << ByteKernel::Name(ByteKernel::Active())
+		<< ", blocks " << board.BlockWidth() << "x" << board.BlockHeight() << ", seeded in " << seeded << " ms" << std::endl;
+
+	// --jump goes straight to a far generation, and the run carries on from there
+	if (options.jump > 0)
+	{
+		const Clock::time_point jumping = Clock::now();
+		board.Advance(rule, options.jump);
+		const double jumped = std::chrono::duration<double, std::milli>(Clock::now() - jumping).count();
+		std::cout << "jumped " << options.jump << " generations in " << jumped << " ms, live: " << board.GetLiveCount() << std::endl;
+	}
+
+	// --compare runs the same start on another engine, and both boards get hashed every generation
+	std::unique_ptr<Board> other;
+	std::optional<int64_t> differs;
+	if (options.compare)
+	{
+		other = std::make_unique<Board>(options.width, options.height, *options.compare);
+		other->SetThreads(options.threads);
+		other->SetBlockSize(options.blockWidth, options.blockHeight);
+		other->SetStepSize(options.step);
+		if (!Seed(*other, options))
+		{
+			return -1;
+		}
+		other->Advance(rule, options.jump);
+		if (other->Hash() != board.Hash())
+		{
+			differs = board.Generation();
+		}
+	}
+
+	// snapshots are part of the step they follow, the writing isn't
+	std::unique_ptr<Checkpointer> checkpointer;
+	if (!options.checkpoint.empty())
+	{
+		checkpointer = std::make_unique<Checkpointer>(options.checkpoint, options.checkpointEvery, rule.ToString(), board.Generation());
+	}
+
+	// the phases only get timed when there's a trace to put them in
+	if (!options.trace.empty())
+	{
+		Profiler::StartTrace(TraceEvents);
+	}
+
+	// a restored board carries on from its generation
+	const int64_t first = board.Generation();
+	std::vector<double> steps;
+	board.ResetWorkers();
+	const Clock::time_point start = Clock::now();
+	while (board.Generation() - first < options.generations && !differs)
+	{
+		const Clock::time_point begin = Clock::now();
+		{
+			ProfileScope scope(Profiler::Phase::Rule);
+			board.UpdateBoard(rule);
+		}
+		{
+			ProfileScope scope(Profiler::Phase::Commit);
+			board.NextGeneration();
+		}
+		if (checkpointer)
+		{
+			checkpointer->Offer(board);
+		}
+		steps.push_back(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+
+		// a HashLife board can take bigger steps, the other one catches up before they're compared
+		while (other && other->Generation() < board.Generation())
+		{
+			other->UpdateBoard(rule);
+			other->NextGeneration();
+		}
+		if (other && other->Generation() == board.Generation() && other->Hash() != board.Hash())
+		{
+			differs = board.Generation();
+		}
+
+		if (options.untilStable && board.Cycles().Period() > 0)
+		{
+			break;
+		}
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	// so the run can carry on from exactly here
+	if (checkpointer)
+	{
+		checkpointer->Finish(board);
+	}
+
+	const double generations = static_cast<double>(board.Generation() - first);
+	std::cout << board.Generation() - first << " generations in " << seconds << " s\n"
+		<< "generations/s: " << generations / seconds << "\n"
+		<< "cell updates/s: " << generations * options.width * options.height / seconds << "\n"
+		<< "step p50: " << Percentile(steps, 0.50) << " ms, p99: " << Percentile(steps, 0.99) << " ms\n"
+		<< "live: " << board.GetLiveCount() << "\n"
+		<< "hash: " << std::hex << board.Hash() << std::dec << "\n";
+
+	if (Profiler::Enabled())
+	{
+		for (const Profiler::Phase phase : { Profiler::Phase::Rule, Profiler::Phase::Commit })
+		{
+			const Profiler::Summary summary = Profiler::Summarize(phase);
+			std::cout << Profiler::Name(phase) << " p50: " << summary.p50Us << " us, p99: " << summary.p99Us << " us, max: " << summary.maxUs << " us\n";
+		}
+	}
+
+	// how evenly the rule passes got spread, a worker that's mostly stealing had too little of its own
+	const std::vector<ThreadPool::WorkerStats> workers = board.Workers();
+	const double elapsedNs = static_cast<double>(std::max<int64_t>(board.WorkersElapsedNs(), 1));
+	for (size_t worker = 0; worker < workers.size(); worker++)
+	{
+		std::cout << "worker " << worker << ": " << workers[worker].tasks << " tasks, " << workers[worker].stolen << " stolen, "
+			<< 100.0 * static_cast<double>(workers[worker].busyNs) / elapsedNs << "% busy\n";
+	}
+
+	const CycleDetector& cycles = board.Cycles();
+	if (cycles.Extinct())
+	{
+		std::cout << "died out at generation " << cycles.ExtinctSince() << std::endl;
+	}
+	else if (cycles.Period() > 0)
+	{
+		std::cout << "cycle: period " << cycles.Period() << " from generation " << cycles.Start() << std::endl;
+	}
+	else
+	{
+		std::cout << "cycle: none with a period up to " << CycleDetector::History << std::endl;
+	}
+
+	if (differs)
+	{
+		std::cout << "compare: differs from " << EngineName(*options.compare) << " at generation " << *differs << std::endl;
+	}
+	else if (other)
+	{
+		std::cout << "compare: same as " << EngineName(*options.compare) << " every generation" << std::endl;
+	}
+
+	return (Save(board, rule.ToString(), options) && !differs) ? 0 : -1;
+}
+
+int Benchmark::Sweep(const Options& options)
+{
+	const Rule rule = *Rule::Parse(options.rule);
+	const CacheSizes& caches = CacheSizes::Get();
+	std::cout << "engine " << EngineName(options.engine) << ", " << rule.ToString() << ", seed " << options.seed
+		<< ", L1 " << caches.l1 / 1024 << " KB, L2 " << caches.l2 / 1024 << " KB, last level " << caches.l3 / 1024 << " KB" << std::endl;
+
+	// both buffers and the neighbors, what the Cells and Incremental engines go through every step
+	// Packed is two bits a cell, Sparse keeps a byte a cell for each of the two views of the window,
+	// and HashLife only has its tree, which a soup this dense doesn't get much below a bit a cell
+	const bool blocks = options.engine == Board::Engine::Cells;
+	int64_t bitsPerCell = 56;
+	if (options.engine == Board::Engine::Packed)
+	{
+		bitsPerCell = 2;
+	}
+	else if (options.engine == Board::Engine::Sparse)
+	{
+		bitsPerCell = 16;
+	}
+	else if (options.engine == Board::Engine::HashLife)
+	{
+		bitsPerCell = 1;
+	}
+	for (int side = 256; ; side *= 2)
+	{
+		// about the same number of cell updates at every size
+		const int64_t cells = int64_t{ side } * side;
+		const int64_t bytes = (cells * bitsPerCell) / 8;
+		const int64_t generations = std::max<int64_t>(4, (options.generations * 65536) / cells);
+		std::cout << side << "x" << side << ", " << bytes / (1024 * 1024) << " MB, " << generations << " generations:";
+
+		for (const bool cached : { true, false })
+		{
+			if (!cached && !blocks)
+			{
+				break;
+			}
+
+			// the blocks the caches pick, then whole rows a tile high which is the plain row by row walk
+			Board board(side, side, options.engine);
+			board.SetThreads(options.threads);
+			board.SetBlockSize(cached ? options.blockWidth : side, cached ? options.blockHeight : ActiveTiles::Size);
+			board.SetTopology(options.topology);
+			board.Fill(options.density, options.seed);
+
+			const auto start = std::chrono::steady_clock::now();
+			for (int64_t generation = 0; generation < generations; generation++)
+			{
+				board.UpdateBoard(rule);
+				board.NextGeneration();
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << (cached ? " " : ", ");
+			if (blocks)
+			{
+				std::cout << (cached ? "blocks " : "rows ") << board.BlockWidth() << "x" << board.BlockHeight() << " ";
+			}
+			std::cout << static_cast<double>(generations * cells) / seconds << " cells/s";
+		}
+		std::cout << std::endl;
+
+		// the Packed engine would take a very big board to get there
+		if (bytes > static_cast<int64_t>(caches.l3) || side >= 16384)
+		{
+			return 0;
+		}
+	}
+}
+
+int Benchmark::RunStriped(const Options& options)
+{
+	const Rule rule = *Rule::Parse(options.rule);
+	if (!rule.IsPlain())
+	{
+		std::cout << "TerminalLife: --processes only runs plain B/S rules" << std::endl;
+		return -1;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point seeding = Clock::now();
+	const std::unique_ptr<Stripes> stripes = Stripes::Start(options.width, options.height, options.processes, options.topology, rule.Packed(), options.density, options.seed);
+	// the workers fill their own stripes, an empty step waits for them to finish
+	if (!stripes || !stripes->Step(0))
+	{
+		return -1;
+	}
+	const double seeded = std::chrono::duration<double, std::milli>(Clock::now() - seeding).count();
+
+	std::cout << "engine " << EngineName(Board::Engine::Packed) << ", " << options.width << "x" << options.height << " " << TopologyName(options.topology) << ", " << rule.ToString()
+		<< ", seed " << options.seed << ", " << Source(options) << ", " << stripes->Processes() << " processes, seeded in " << seeded << " ms" << std::endl;
+
+	// a generation a command, so the steps time the exchange between the stripes as well
+	std::vector<double> steps;
+	const Clock::time_point start = Clock::now();
+	while (stripes->Generation() < options.generations)
+	{
+		const Clock::time_point begin = Clock::now();
+		if (!stripes->Step(1))
+		{
+			std::cout << "TerminalLife: a worker process went away at generation " << stripes->Generation() << std::endl;
+			return -1;
+		}
+		steps.push_back(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	const std::optional<Stripes::Tally> tally = stripes->Count();
+	if (!tally)
+	{
+		std::cout << "TerminalLife: a worker process went away" << std::endl;
+		return -1;
+	}
+
+	const double generations = static_cast<double>(stripes->Generation());
+	std::cout << stripes->Generation() << " generations in " << seconds << " s\n"
+		<< "generations/s: " << generations / seconds << "\n"
+		<< "cell updates/s: " << generations * options.width * options.height / seconds << "\n"
+		<< "step p50: " << Percentile(steps, 0.50) << " ms, p99: " << Percentile(steps, 0.99) << " ms\n"
+		<< "live: " << tally->live << "\n"
+		<< "hash: " << std::hex << tally->hash << std::dec << std::endl;
+	return 0;
+}
@@ -0,0 +1,89 @@
+﻿#pragma once
+#include "Board.h"
+#include "Stripes.h"
+
+// runs an engine flat out with no console and reports how fast it went
+// the final hash only depends on the cells, so runs with different engines or thread counts can be compared
+// (the HashLife and Sparse planes don't wrap around, so they only agree with the others until something reaches an edge)
+// --compare checks every generation against a second engine instead of just the last
+class Benchmark
+{
+public:
+    struct Options
+    {
+        int width = 1024;
+        int height = 1024;
+        std::string rule = "B3/S23";
+        uint64_t seed = 1;
+        // fraction of the board Board::Fill makes live
+        double density = 0.25;
+        // one of Patterns::All in the middle of an empty board instead of a random fill
+        std::string pattern;
+        // an RLE or .cells file to start from instead, with its top left at (atX, atY)
+        std::string load;
+        int atX = 0;
+        int atY = 0;
+        // where the last generation goes as RLE when the run ends
+        std::string save;
+        // a binary checkpoint to start from, it sets the size
+        std::string restore;
+        // where a checkpoint gets written every checkpointEvery generations
+        std::string checkpoint;
+        int64_t checkpointEvery = 10000;
+        int64_t generations = 1000;
+        Board::Engine engine = Board::Engine::Cells;
+        // another engine run alongside from the same start, the run stops at the first generation the two boards differ
+        std::optional<Board::Engine> compare;
+        // what's past the edges, the HashLife and Sparse planes don't have any
+        Topology topology = Topology::Torus;
+        int threads = static_cast<int>(std::thread::hardware_concurrency());
+        // more than one splits the board into stripes, each stepped by its own process with the Packed engine's bit planes
+        int processes = 1;
+        // HashLife only, 2^step generations per UpdateBoard
+        int step = 0;
+        // HashLife only, how far to jump ahead in one go once the board is seeded, before anything is timed or drawn
+        int64_t jump = 0;
+        // Cells only, the widest the CPU can do unless this says otherwise
+        std::optional<ByteKernel::Level> kernel;
+        // Cells only, how much of the board a step walks at a time, 0 sizes the blocks from the caches
+        int blockWidth = 0;
+        int blockHeight = 0;
+        // square boards that double in size until they're bigger than the last level cache, instead of one run
+        bool sweep = false;
+        // stop as soon as the board dies out, freezes or starts repeating
+        bool untilStable = false;
+        // where the History goes as CSV when the run ends, keeping it slows every step down a little
+        std::string history;
+        // where the Profiler's trace goes as Chrome trace-event JSON when the run ends
+        std::string trace;
+    };
+
+    // how many scopes --trace keeps, about 24MB of them, anything after that only goes in the histograms
+    static constexpr size_t TraceEvents = 1 << 20;
+
+    // true if --bench is on the command line
+    static bool Requested(int argc, char* argv[]);
+
+    static std::optional<Options> Parse(int argc, char* argv[]);
+
+    static void PrintUsage();
+
+    // sets the topology and fills board the way options ask for, false if the pattern file or checkpoint couldn't be read
+    static bool Seed(Board& board, const Options& options);
+
+    // how many generations of History a run with these options keeps
+    static size_t HistoryLength(const Options& options);
+
+    // writes the board to options.save, its history to options.history and the trace to options.trace if asked, false if that failed
+    static bool Save(const Board& board, std::string_view rule, const Options& options);
+
+    // returns what main should return
+    static int Run(const Options& options);
+
+    // Run's --sweep, cell updates a second for each size with the blocks the caches ask for and
+    // with plain rows, so it's easy to see whether the rate holds up once the board stops fitting in cache
+    static int Sweep(const Options& options);
+
+    // Run's --processes, the same report from a board split into Stripes
+    static int RunStriped(const Options& options);
+};
@@ -0,0 +1,149 @@
+﻿#include "pch.h"
+#include "BitBoard.h"
+
+BitBoard::BitBoard(int width, int height)
+	: _width(width), _height(height), _words((width + 63) / 64), _lastBit((width - 1) & 63)
+{
+	_lastMask = (_lastBit == 63) ? ~uint64_t{ 0 } : ((uint64_t{ 1 } << (_lastBit + 1)) - 1);
+	_cells.resize(static_cast<size_t>(_words) * _height);
+	_next.resize(_cells.size());
+	_above.resize(_words, 0);
+	_below.resize(_words, 0);
+	_tiles = ActiveTiles(_words, (_height + ActiveTiles::Size - 1) / ActiveTiles::Size);
+}
+
+void BitBoard::Clear()
+{
+	std::fill(_cells.begin(), _cells.end(), 0);
+	_tiles.MarkAllActive();
+}
+
+void BitBoard::SetTopology(Topology topology)
+{
+	_topology = topology;
+	_wrap = (topology == Topology::Bounded) ? 0 : 1;
+	_tiles.SetTwisted(topology == Topology::Klein);
+}
+
+void BitBoard::FillHalo()
+{
+	if (_topology == Topology::Bounded || _topology == Topology::Cylinder)
+	{
+		// dead, and nothing ever writes them
+		std::fill(_above.begin(), _above.end(), 0);
+		std::fill(_below.begin(), _below.end(), 0);
+		return;
+	}
+
+	const uint64_t* top = Row(0);
+	const uint64_t* bottom = Row(_height - 1);
+	if (_topology == Topology::Torus)
+	{
+		std::copy(bottom, bottom + _words, _above.begin());
+		std::copy(top, top + _words, _below.begin());
+		return;
+	}
+
+	// Klein, the other edge comes back mirrored. one row, so a bit at a time is fine
+	std::fill(_above.begin(), _above.end(), 0);
+	std::fill(_below.begin(), _below.end(), 0);
+	for (int x = 0; x < _width; x++)
+	{
+		const int mirror = _width - 1 - x;
+		_above[x >> 6] |= ((bottom[mirror >> 6] >> (mirror & 63)) & 1) << (x & 63);
+		_below[x >> 6] |= ((top[mirror >> 6] >> (mirror & 63)) & 1) << (x & 63);
+	}
+}
+
+void BitBoard::SetHalo(const uint64_t* above, const uint64_t* below)
+{
+	const int bottom = _tiles.Rows() - 1;
+	for (int i = 0; i < _words; i++)
+	{
+		if (above[i] != _above[i])
+		{
+			_tiles.Wake(i, 0);
+		}
+		if (below[i] != _below[i])
+		{
+			_tiles.Wake(i, bottom);
+		}
+	}
+	std::copy(above, above + _words, _above.begin());
+	std::copy(below, below + _words, _below.begin());
+}
+
+uint64_t BitBoard::StepRows(const PackedRule& rule, int y0, int y1)
+{
+	uint64_t hash = 0;
+	for (int y = y0; y < y1; y++)
+	{
+		// past the top and bottom are the halo rows
+		const uint64_t* above = (y == 0) ? _above.data() : Row(y - 1);
+		const uint64_t* row = Row(y);
+		const uint64_t* below = (y == _height - 1) ? _below.data() : Row(y + 1);
+		uint64_t* next = &_next[static_cast<size_t>(y) * _words];
+		const int ty = y / ActiveTiles::Size;
+
+		for (int i = 0; i < _words; i++)
+		{
+			// nothing around here changed last time, so the back buffer already has this word right
+			if (!_tiles.IsActive(i, ty))
+			{
+				continue;
+			}
+
+			const uint64_t alive = row[i];
+			uint64_t result = NextWord(rule, West(above, i), above[i], East(above, i), West(row, i), alive, East(row, i), West(below, i), below[i], East(below, i));
+
+			// keep the padding bits at the end of the row dead
+			if (i == _words - 1)
+			{
+				result &= _lastMask;
+			}
+
+			if (result != alive)
+			{
+				_tiles.MarkChanged(i, ty);
+
+				// one key per cell that flipped
+				for (uint64_t flips = result ^ alive; flips != 0; flips &= flips - 1)
+				{
+					hash ^= Zobrist::Key((static_cast<uint64_t>(y) * _width) + (i * 64) + std::countr_zero(flips), 1);
+				}
+			}
+			next[i] = result;
+		}
+	}
+	return hash;
+}
+
+int BitBoard::Population() const
+{
+	int count = 0;
+	for (const uint64_t word : _cells)
+	{
+		count += std::popcount(word);
+	}
+	return count;
+}
+
+int BitBoard::CountBorn() const
+{
+	int count = 0;
+	for (size_t i = 0; i < _cells.size(); i++)
+	{
+		count += std::popcount(_next[i] & ~_cells[i]);
+	}
+	return count;
+}
+
+int BitBoard::CountDying() const
+{
+	int count = 0;
+	for (size_t i = 0; i < _cells.size(); i++)
+	{
+		count += std::popcount(_cells[i] & ~_next[i]);
+	}
+	return count;
+}
@@ -0,0 +1,196 @@
+﻿#pragma once
+#include "Rule.h"
+#include "ActiveTiles.h"
+#include "Zobrist.h"
+#include "Topology.h"
+
+// bit-plane storage, 64 cells per word. cell x of a row is bit (x % 64) of word (x / 64)
+// rows are padded out to whole words and the padding bits are always kept at zero
+// what's past the edges is up to the Topology, the rows above the top and below the bottom are a halo
+// filled in before every step and the cells past the left and right ends come in through _wrap
+class BitBoard
+{
+private:
+    std::vector<uint64_t> _cells;
+    std::vector<uint64_t> _next;
+    int _width = 0;
+    int _height = 0;
+    int _words = 0;
+    int _lastBit = 0;
+    uint64_t _lastMask = 0;
+    // a tile is one word wide and ActiveTiles::Size rows high
+    ActiveTiles _tiles;
+    Topology _topology = Topology::Torus;
+    // the halo rows, row -1 and row _height
+    std::vector<uint64_t> _above;
+    std::vector<uint64_t> _below;
+    // 1 if the cells past the left and right ends are the other end of the row, 0 if they're dead
+    uint64_t _wrap = 1;
+
+    // bit-sliced adders, every bit position is its own independent adder
+    static void HalfAdd(uint64_t a, uint64_t b, uint64_t& sum, uint64_t& carry)
+    {
+        sum = a ^ b;
+        carry = a & b;
+    }
+
+    static void FullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry)
+    {
+        const uint64_t t = a ^ b;
+        sum = t ^ c;
+        carry = (a & b) | (t & c);
+    }
+
+    // bit x of the result holds cell x-1 of the row, wrapping at the left edge if the topology does
+    uint64_t West(const uint64_t* row, int i) const
+    {
+        const uint64_t carry = (i == 0) ? (row[_words - 1] >> _lastBit) & _wrap : (row[i - 1] >> 63);
+        return (row[i] << 1) | (carry & 1);
+    }
+
+    // bit x of the result holds cell x+1 of the row, wrapping at the right edge if the topology does
+    uint64_t East(const uint64_t* row, int i) const
+    {
+        if (i == _words - 1)
+        {
+            return (row[i] >> 1) | ((row[0] & _wrap) << _lastBit);
+        }
+        return (row[i] >> 1) | (row[i + 1] << 63);
+    }
+
+public:
+    BitBoard() = default;
+
+    // the next generation of 64 cells at once. the nine words are the row above, the cells' own row and the row below,
+    // each as west (bit x holds cell x-1), centre and east (bit x holds cell x+1)
+    static uint64_t NextWord(const PackedRule& rule, uint64_t nw, uint64_t n, uint64_t ne, uint64_t w, uint64_t alive, uint64_t e, uint64_t sw, uint64_t s, uint64_t se)
+    {
+        // add up the eight neighbors of 64 cells at once into a 4 bit count (b3 b2 b1 b0)
+        uint64_t sa, ca, sb, cb, sc, cc;
+        FullAdd(nw, n, ne, sa, ca);
+        FullAdd(sw, s, se, sb, cb);
+        HalfAdd(w, e, sc, cc);
+
+        uint64_t b0, c1;
+        FullAdd(sa, sb, sc, b0, c1);
+
+        uint64_t t, c2a, b1, c2b;
+        FullAdd(ca, cb, cc, t, c2a);
+        HalfAdd(t, c1, b1, c2b);
+
+        uint64_t b2, b3;
+        HalfAdd(c2a, c2b, b2, b3);
+
+        uint64_t result = 0;
+        for (int count = 0; count <= 8; count++)
+        {
+            const bool born = (rule.birth >> count) & 1;
+            const bool survives = (rule.survive >> count) & 1;
+            if (!born && !survives)
+            {
+                continue;
+            }
+
+            const uint64_t match = ((count & 1) ? b0 : ~b0) & ((count & 2) ? b1 : ~b1) & ((count & 4) ? b2 : ~b2) & ((count & 8) ? b3 : ~b3);
+            if (born && survives)
+            {
+                result |= match;
+            }
+            else if (born)
+            {
+                result |= match & ~alive;
+            }
+            else
+            {
+                result |= match & alive;
+            }
+        }
+        return result;
+    }
+    BitBoard(int width, int height);
+
+    int Words() const
+    {
+        return _words;
+    }
+
+    const uint64_t* Row(int y) const
+    {
+        return &_cells[static_cast<size_t>(y) * _words];
+    }
+
+    bool Get(int x, int y) const
+    {
+        // no bounds checking
+        return (Row(y)[x >> 6] >> (x & 63)) & 1;
+    }
+
+    // the state Step() computed for the next generation, only valid until Swap()
+    bool GetNext(int x, int y) const
+    {
+        return (_next[(static_cast<size_t>(y) * _words) + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    void Set(int x, int y, bool alive)
+    {
+        // no bounds checking
+        uint64_t& word = _cells[(static_cast<size_t>(y) * _words) + (x >> 6)];
+        const uint64_t bit = uint64_t{ 1 } << (x & 63);
+        word = alive ? (word | bit) : (word & ~bit);
+        _tiles.MarkAllActive();
+    }
+
+    // writes cells 64*i to 64*i+63 of row y at once, the padding past the last cell gets dropped
+    // doesn't wake any tiles so several threads can fill rows at once, call Tiles().MarkAllActive() after
+    void SetWord(int y, int i, uint64_t word)
+    {
+        _cells[(static_cast<size_t>(y) * _words) + i] = (i == _words - 1) ? (word & _lastMask) : word;
+    }
+
+    void Clear();
+
+    void SetTopology(Topology topology);
+
+    // copies whatever the topology puts past the top and bottom into the halo rows, before every step
+    void FillHalo();
+
+    // instead of FillHalo, for a board that's a stripe of a bigger one: the rows past the top and bottom
+    // are whatever the stripes either side say they are, and any words that changed wake the tiles next to them
+    void SetHalo(const uint64_t* above, const uint64_t* below);
+
+    // computes the next generation of every row into the back buffer
+    // tiles that can't have changed are skipped, call Tiles().MarkAllActive() after switching rules
+    void Step(const PackedRule& rule)
+    {
+        FillHalo();
+        StepRows(rule, 0, _height);
+        _tiles.Update();
+    }
+
+    // computes the next generation of rows [y0, y1) into the back buffer, y0 on a tile boundary
+    // somebody has to call FillHalo() before the first band and Tiles().Update() once every band is done
+    // returns what the Zobrist hash of the board changes by
+    uint64_t StepRows(const PackedRule& rule, int y0, int y1);
+
+    ActiveTiles& Tiles()
+    {
+        return _tiles;
+    }
+
+    const ActiveTiles& Tiles() const
+    {
+        return _tiles;
+    }
+
+    // makes the generation computed by Step() current
+    void Swap()
+    {
+        _cells.swap(_next);
+    }
+
+    int Population() const;
+
+    // cells that are dead now and alive after Step(), and the other way around
+    int CountBorn() const;
+    int CountDying() const;
+};
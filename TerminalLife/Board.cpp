@@ -2,283 +2,877 @@
 // as x increases move right, as y increases move down
 #include "pch.h"
 #include "Board.h"
+#include "Frame.h"
+#include "SplitMix.h"
+#include "CacheSizes.h"
 
-// optimized to never use std::endl until the full board is done printing
-std::ostream& operator<<(std::ostream& stream, Board& board)
+Board::Board(int width, int height, Engine engine)
+	: _front(&_buffers[0]), _back(&_buffers[1]), _sweep(false), _fading(0), _evaluated(0), _lastRule{}, _lastStates(0), _width(width), _height(height), _size(width* height), _generation(0), _engine(engine), _topology(Topology::Torus), _lifeStep(0), _pending(false), _hash(0), _nextHash(0), _bandCounts(1)
 {
-	static std::u8string str(((board.Width() + 2) * board.Height()) + 1, ' ');
-	// clear the static string of any leftover goo
-	str.clear();
+	if (_engine == Engine::Packed)
+	{
+		// the bits are the whole board, don't pay for the Cells
+		_bits = BitBoard(_width, _height);
+		return;
+	}
 
-	for (int y = 0; y < board.Height(); y++)
+	if (OnPlane())
 	{
-		for (int x = 0; x < board.Width(); x++)
+		// HashLife's tree is the board, Sparse keeps the window as bytes as well
+		if (HasView())
 		{
-			const Cell& cell = board.GetCell(x, y);
-			str += cell.GetEmojiStateString();
+			_view.resize(_size, 0);
+			_nextView.resize(_size, 0);
 		}
-		str += u8"\r\n";
+		return;
+	}
+
+	for (Buffer& buffer : _buffers)
+	{
+		buffer.state.resize(_size, static_cast<uint8_t>(Cell::State::Dead));
+		buffer.born.resize(_size, 0);
+	}
+	_neighbors.resize(_size, 0);
+	_haloAbove.resize(static_cast<size_t>(_width) + 2, 0);
+	_haloBelow.resize(_haloAbove.size(), 0);
+	_haloLeft.resize(static_cast<size_t>(_height) + 2, 0);
+	_haloRight.resize(_haloLeft.size(), 0);
+	if (_engine == Engine::Incremental)
+	{
+		_queued.resize(_size, 0);
+	}
+
+	_tiles = ActiveTiles((_width + ActiveTiles::Size - 1) / ActiveTiles::Size, (_height + ActiveTiles::Size - 1) / ActiveTiles::Size);
+	_tileLive.resize(static_cast<size_t>(_tiles.Columns()) * _tiles.Rows(), 0);
+	SizeBlocks();
+}
+
+void Board::SetThreads(int threads)
+{
+	threads = std::max(threads, 1);
+	if (threads == Bands())
+	{
+		return;
 	}
 
-	printf((const char*)str.c_str());
-	return stream;
+	_pool = (threads > 1) ? std::make_unique<ThreadPool>(threads) : nullptr;
+	_bandCounts.resize(threads);
+	SizeBlocks();
 }
 
-Board::Board(int width, int height)
-	: _width(width), _height(height), _size(width* height), _generation(0), _x(0), _y(0)
+void Board::SizeBlocks()
 {
-	_board.resize(_size);
-	for (int x = 0; x < _width; x++)
+	if (!HasCells())
 	{
+		return;
+	}
+
+	// going along a block row reads three rows of states and one of born, and writes a row of states,
+	// born and neighbors, about 9 bytes a column. two of those should sit in half of L1
+	const CacheSizes& caches = CacheSizes::Get();
+	const int width = (_blockWidth > 0) ? _blockWidth : static_cast<int>(caches.l1 / (2 * 2 * 9));
+	// and a whole block, 7 bytes a cell in both buffers and the neighbors, in half of L2
+	const int height = (_blockHeight > 0) ? _blockHeight : static_cast<int>(caches.l2 / (2 * 7 * static_cast<size_t>(std::min(width, _width))));
+
+	_blocks.tilesX = std::clamp(width / ActiveTiles::Size, 1, _tiles.Columns());
+	_blocks.tilesY = std::clamp(height / ActiveTiles::Size, 1, _tiles.Rows());
+	_blocks.columns = (_tiles.Columns() + _blocks.tilesX - 1) / _blocks.tilesX;
+
+	// auto sized blocks get shorter until every thread has a few, if the board is big enough for that
+	const int wanted = (_blockHeight > 0) ? 1 : 4 * Bands();
+	const int rowsWanted = (wanted + _blocks.columns - 1) / _blocks.columns;
+	_blocks.tilesY = std::clamp(_tiles.Rows() / rowsWanted, 1, _blocks.tilesY);
+	_blocks.rows = (_tiles.Rows() + _blocks.tilesY - 1) / _blocks.tilesY;
+}
+
+void Board::SetTopology(Topology topology)
+{
+	if (OnPlane())
+	{
+		return;
+	}
+
+	_topology = topology;
+	_tiles.SetTwisted(topology == Topology::Klein);
+	_bits.SetTopology(topology);
+	Settle();
+}
+
+void Board::FillHalo()
+{
+	const auto state = [this](int x, int y) -> uint8_t
+	{
+		return WrapCell(_topology, _width, _height, x, y) ? _front->state[Index(x, y)] : 0;
+	};
+
+	if (_topology == Topology::Torus)
+	{
+		// the common case, straight copies of the far rows and columns
+		std::memcpy(&_haloAbove[1], StateRow(_height - 1), _width);
+		std::memcpy(&_haloBelow[1], StateRow(0), _width);
 		for (int y = 0; y < _height; y++)
 		{
-			// gotta be a better way?
-			_board[x + (y * _width)].SetXY(x, y);
+			_haloLeft[y + 1] = StateRow(y)[_width - 1];
+			_haloRight[y + 1] = StateRow(y)[0];
 		}
 	}
+	else
+	{
+		for (int x = 0; x < _width; x++)
+		{
+			_haloAbove[x + 1] = state(x, -1);
+			_haloBelow[x + 1] = state(x, _height);
+		}
+		for (int y = 0; y < _height; y++)
+		{
+			_haloLeft[y + 1] = state(-1, y);
+			_haloRight[y + 1] = state(_width, y);
+		}
+	}
+
+	// the corners are in both a row and a column
+	_haloAbove[0] = _haloLeft[0] = state(-1, -1);
+	_haloAbove[_width + 1] = _haloRight[0] = state(_width, -1);
+	_haloBelow[0] = _haloLeft[_height + 1] = state(-1, _height);
+	_haloBelow[_width + 1] = _haloRight[_height + 1] = state(_width, _height);
 }
 
-void Board::PrintBoard()
+void Board::ReduceCounts()
 {
-	std::cout << (*this) << std::endl;
+	_counts = CellCounts();
+	for (const BandCounts& band : _bandCounts)
+	{
+		_counts += band.counts;
+	}
 }
 
-int Board::CountLiveAndDyingNeighbors(Cell& cell)
+void Board::UpdateLifeCounts()
 {
-	static int x = 0;
-	static int y = 0;
-	x = cell.X();
-	y = cell.Y();
+	// live is the whole plane, the rest only what's in the window. nothing gets copied out of the tree,
+	// the window's cells come from node populations and only the squares the step changed get looked into
+	uint64_t born = 0;
+	uint64_t dying = 0;
+	_life.Changes(0, 0, _width, _height, born, dying);
+	_counts = CellCounts();
+	_counts.live = static_cast<int>(std::min<uint64_t>(_life.Population(), std::numeric_limits<int>::max()));
+	_counts.dead = _size - static_cast<int>(_life.Population(0, 0, _width, _height));
+	_counts.born = static_cast<int>(born);
+	_counts.dying = static_cast<int>(dying);
+	_nextHash = _life.Hash();
+}
+
+void Board::UpdateSparseView()
+{
+	// the part of chunk c that's in the window, false if none of it is
+	const auto clip = [this](const SparsePlane::Coord& c, int& x0, int& y0, int& x1, int& y1)
+	{
+		x0 = c.x * SparsePlane::Size;
+		y0 = c.y * SparsePlane::Size;
+		x1 = std::min(_width, x0 + SparsePlane::Size);
+		y1 = std::min(_height, y0 + SparsePlane::Size);
+		return c.x >= 0 && c.y >= 0 && x0 < _width && y0 < _height;
+	};
+
+	// _nextView still holds the generation before _view, so first catch it up where the last step changed things
+	int x0, y0, x1, y1;
+	for (const SparsePlane::Coord& c : _viewChanged)
+	{
+		clip(c, x0, y0, x1, y1);
+		for (int y = y0; y < y1; y++)
+		{
+			std::memcpy(&_nextView[Index(x0, y)], &_view[Index(x0, y)], x1 - x0);
+		}
+	}
 
-	// calculate offsets that wrap
-	int xoleft = (x == 0) ? _width - 1 : -1;
-	int xoright = (x == (_width - 1)) ? -(_width - 1) : 1;
-	int yoabove = (y == 0) ? _height - 1 : -1;
-	int yobelow = (y == (_height - 1)) ? -(_height - 1) : 1;
+	// live and the hash are the whole plane, the rest only what's in the window, like HashLife
+	CellCounts counts;
+	counts.live = static_cast<int>(std::min<uint64_t>(_plane.Population(), std::numeric_limits<int>::max()));
+	counts.dead = _counts.dead;
+	_nextHash = _plane.Hash();
+	_viewChanged.clear();
+	for (const SparsePlane::Coord& c : _plane.Changed())
+	{
+		if (!clip(c, x0, y0, x1, y1))
+		{
+			continue;
+		}
 
-	int count = 0;
+		_plane.Extract(x0, y0, x1 - x0, y1 - y0, &_nextView[Index(x0, y0)], _width);
+		for (int y = y0; y < y1; y++)
+		{
+			for (int i = Index(x0, y); i < Index(x1, y); i++)
+			{
+				const int born = (_nextView[i] != 0) & (_view[i] == 0);
+				const int dying = (_nextView[i] == 0) & (_view[i] != 0);
+				counts.born += born;
+				counts.dying += dying;
+				counts.dead += dying - born;
+			}
+		}
+		_viewChanged.push_back(c);
+	}
+	_counts = counts;
+}
 
-	if (GetCell(x + xoleft, y + yobelow).IsAlive()) count++;
-	if (GetCell(x, y + yobelow).IsAlive()) count++;
-	if (GetCell(x + xoright, y + yobelow).IsAlive()) count++;
+// the rule pass already settled the next generation into the back buffer, so this is just a swap
+void Board::NextGeneration()
+{
+	// the packed engine only knows who was born or died while the next generation is pending
+	const bool sample = _history.Capacity() > 0;
+	const int born = sample ? GetBornCount() : 0;
+	const int dying = sample ? GetDyingCount() : 0;
 
-	if (GetCell(x + xoleft, y + yoabove).IsAlive()) count++;
-	if (GetCell(x, y + yoabove).IsAlive()) count++;
-	if (GetCell(x + xoright, y + yoabove).IsAlive()) count++;
+	_generation += GenerationsPerStep();
+	if (_pending)
+	{
+		_hash = _nextHash;
+	}
+	_pending = false;
 
-	if (GetCell(x + xoleft, y).IsAlive()) count++;
-	if (GetCell(x + xoright, y).IsAlive()) count++;
+	// with OldAge on the ages matter too, and they never repeat
+	if (HasCells() && Cell::GetOldAge() > 0)
+	{
+		_cycles.Reset();
+	}
+	else
+	{
+		_cycles.Record(_generation, _hash, IsEmpty());
+	}
 
-	cell.SetNeighbors(count);
+	if (_engine == Engine::Packed)
+	{
+		_bits.Swap();
+	}
+	else if (HasView())
+	{
+		_view.swap(_nextView);
+	}
+	else if (HasCells())
+	{
+		// the counts were taken for this generation when the rule pass ran
+		std::swap(_front, _back);
+	}
 
-	return count;
+	if (sample)
+	{
+		Sample next = TakeSample();
+		next.counts.born = born;
+		next.counts.dying = dying;
+		_history.Push(next);
+	}
 }
 
-int Board::CountLiveNotDyingNeighbors(Cell& cell)
+Bounds Board::LiveBounds() const
 {
-	static int x = 0;
-	static int y = 0;
-	x = cell.X();
-	y = cell.Y();
+	if (_engine == Engine::HashLife)
+	{
+		int64_t left, top, right, bottom;
+		if (!_life.Bounds(0, 0, _width, _height, left, top, right, bottom))
+		{
+			return Bounds();
+		}
+		return Bounds{ static_cast<int>(left), static_cast<int>(top), static_cast<int>(right), static_cast<int>(bottom) };
+	}
 
-	// calculate offsets that wrap
-	int xoleft = (x == 0) ? _width - 1 : -1;
-	int xoright = (x == (_width - 1)) ? -(_width - 1) : 1;
-	int yoabove = (y == 0) ? _height - 1 : -1;
-	int yobelow = (y == (_height - 1)) ? -(_height - 1) : 1;
+	// first and last live cell of row y in [from, to), -1 if there isn't one
+	const auto first = [this](int y, int from, int to)
+	{
+		if (_engine == Engine::Packed)
+		{
+			const uint64_t* row = _bits.Row(y);
+			for (int x = from; x < to; x = (x | 63) + 1)
+			{
+				const uint64_t word = row[x >> 6] >> (x & 63);
+				if (word != 0)
+				{
+					const int found = x + std::countr_zero(word);
+					return (found < to) ? found : -1;
+				}
+			}
+			return -1;
+		}
 
-	int count = 0;
+		const uint8_t* row = HasView() ? &_view[static_cast<size_t>(y) * _width] : StateRow(y);
+		const void* found = (to > from) ? std::memchr(row + from, 1, to - from) : nullptr;
+		return found ? static_cast<int>(static_cast<const uint8_t*>(found) - row) : -1;
+	};
+	const auto last = [this](int y, int from, int to)
+	{
+		if (_engine == Engine::Packed)
+		{
+			const uint64_t* row = _bits.Row(y);
+			for (int x = to - 1; x >= from; x = (x & ~63) - 1)
+			{
+				const uint64_t word = row[x >> 6] << (63 - (x & 63));
+				if (word != 0)
+				{
+					const int found = x - std::countl_zero(word);
+					return (found >= from) ? found : -1;
+				}
+			}
+			return -1;
+		}
 
-	if (GetCell(x + xoleft, y + yobelow).IsAliveNotDying()) count++;
-	if (GetCell(x, y + yobelow).IsAliveNotDying()) count++;
-	if (GetCell(x + xoright, y + yobelow).IsAliveNotDying()) count++;
+		const uint8_t* row = HasView() ? &_view[static_cast<size_t>(y) * _width] : StateRow(y);
+		for (int x = to - 1; x >= from; x--)
+		{
+			if (row[x] == 1)
+			{
+				return x;
+			}
+		}
+		return -1;
+	};
 
-	if (GetCell(x + xoleft, y + yoabove).IsAliveNotDying()) count++;
-	if (GetCell(x, y + yoabove).IsAliveNotDying()) count++;
-	if (GetCell(x + xoright, y + yoabove).IsAliveNotDying()) count++;
+	int top = 0;
+	while (top < _height && first(top, 0, _width) < 0)
+	{
+		top++;
+	}
+	if (top == _height)
+	{
+		return Bounds();
+	}
 
-	if (GetCell(x + xoleft, y).IsAliveNotDying()) count++;
-	if (GetCell(x + xoright, y).IsAliveNotDying()) count++;
+	int bottom = _height - 1;
+	while (first(bottom, 0, _width) < 0)
+	{
+		bottom--;
+	}
 
-	cell.SetNeighbors(count);
-	return count;
+	Bounds bounds{ _width, top, -1, bottom };
+	for (int y = top; y <= bottom; y++)
+	{
+		const int left = first(y, 0, bounds.left);
+		bounds.left = (left >= 0) ? left : bounds.left;
+		const int right = last(y, bounds.right + 1, _width);
+		bounds.right = (right >= 0) ? right : bounds.right;
+	}
+	return bounds;
 }
 
-//  could probably replace with a template that would call any lambda for all cells
-void Board::NextGeneration()
+void Board::AccumulateRows(int y0, int y1, int x0, int x1, uint64_t* bits) const
 {
-	_generation++;
-	Cell::ResetCounts();
+	const int w0 = x0 >> 6;
+	const int w1 = (x1 + 63) >> 6;
+	std::fill(bits + w0, bits + w1, 0);
+	if (_engine == Engine::HashLife)
+	{
+		// like the other engines this is the generation on screen, which is the one before a pending step
+		_life.AccumulateRows(x0, y0, x1 - x0, y1 - y0, bits, _pending);
+		return;
+	}
 
-	for (int i = 0; i < _size; i++)
+	for (int y = y0; y < y1; y++)
 	{
-		_board[i].NextGeneration();
+		if (_engine == Engine::Packed)
+		{
+			// already bits, 64 cells at a time
+			const uint64_t* row = _bits.Row(y);
+			for (int w = w0; w < w1; w++)
+			{
+				bits[w] |= row[w];
+			}
+			continue;
+		}
+
+		const uint8_t* row = HasView() ? &_view[static_cast<size_t>(y) * _width] : StateRow(y);
+		for (int x = x0; x < x1; x++)
+		{
+			bits[x >> 6] |= static_cast<uint64_t>(row[x] == 1) << (x & 63);
+		}
 	}
 }
 
-void Board::RandomizeBoard(int n)
+void Board::AggregateBlocks(int x, int y, int block, int dots, int rows, uint8_t* out)
 {
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_int_distribution<> xdis(0, _width - 1);
-	std::uniform_int_distribution<> ydis(0, _height - 1);
-	std::uniform_int_distribution<> adis(0, 100);
-
-	int rx, ry, ra;
+	_captureRows.resize(Bands());
+	const int x1 = std::min(_width, x + (dots * block));
 
-	for (int z = 0; z < n; z++)
+	ForEachChunk(rows, [this, x, y, x1, block, dots, out](int band, int begin, int end)
 	{
-		rx = xdis(gen);
-		ry = ydis(gen);
-		ra = adis(gen);
+		std::vector<uint64_t>& bits = _captureRows[band];
+		bits.resize((static_cast<size_t>(_width) + 63) / 64);
 
-		if (Cell& cell = GetCell(rx, ry); cell.GetState() == Cell::State::Dead)
+		for (int r = begin; r < end; r++)
 		{
-			cell.SetState(Cell::State::Born);
-			cell.SetAge(ra);
+			uint8_t* dot = out + (static_cast<size_t>(r) * dots);
+			const int y0 = y + (r * block);
+			if (y0 >= _height)
+			{
+				std::fill(dot, dot + dots, uint8_t{ 0 });
+				continue;
+			}
+			AccumulateRows(y0, std::min(_height, y0 + block), x, x1, bits.data());
+
+			// any bit in [from, to) set
+			for (int d = 0; d < dots; d++)
+			{
+				int from = x + (d * block);
+				const int to = std::min(x1, from + block);
+				uint8_t any = 0;
+				while (from < to && !any)
+				{
+					const int bit = from & 63;
+					const int n = std::min(64 - bit, to - from);
+					const uint64_t mask = (n == 64) ? ~uint64_t{ 0 } : (((uint64_t{ 1 } << n) - 1) << bit);
+					any = (bits[from >> 6] & mask) != 0;
+					from += n;
+				}
+				dot[d] = any;
+			}
 		}
-		NextGeneration();
-	}
+	});
 }
 
-void Board::ConwayRules(Cell& cell) const
+void Board::Capture(Frame& frame, const Viewport& view)
 {
-	// Any live cell with two or three live neighbours survives.
-	// Any dead cell with three live neighbours becomes a live cell.
-	// All other live cells die in the next generation. Similarly, all other dead cells stay dead.
+	frame.zoom = view.zoom;
+	frame.sample = TakeSample();
+	frame.trend.clear();
+	for (size_t i = _history.Size() - std::min(_history.Size(), Frame::TrendLength); i < _history.Size(); i++)
+	{
+		frame.trend.push_back(_history[i].counts.live);
+	}
+	frame.activeRatio = GetActiveRatio();
+	frame.period = _cycles.Period();
 
-	static int count = 0;
-	count = cell.Neighbors();
+	// just the characters the board actually reaches
+	const int x0 = std::clamp(view.x, 0, _width - 1);
+	const int y0 = std::clamp(view.y, 0, _height - 1);
+	frame.width = std::clamp((_width - x0 + view.GlyphWidth() - 1) / view.GlyphWidth(), 0, view.GlyphColumns());
+	frame.height = std::clamp((_height - y0 + view.GlyphHeight() - 1) / view.GlyphHeight(), 0, view.GlyphRows());
+	frame.glyphs.resize(static_cast<size_t>(frame.width) * frame.height);
 
-	if (cell.IsAlive() && count >= 2 && count <= 3)
+	if (view.zoom == 0)
 	{
-		cell.SetState(Cell::State::Live);
-	}
-	else
-		if (cell.IsDead() && count == 3)
+		for (int y = 0; y < frame.height; y++)
 		{
-			cell.SetState(Cell::State::Born);
+			for (int x = 0; x < frame.width; x++)
+			{
+				frame.glyphs[x + (y * frame.width)] = static_cast<uint8_t>(GetCellState(x0 + x, y0 + y));
+			}
 		}
-		else
-			if (cell.IsAlive())
+		return;
+	}
+
+	// 2x4 dots per character, the dot bits are in the order Unicode numbers braille dots
+	static constexpr uint8_t dotBits[4][2] = { { 0x01, 0x08 }, { 0x02, 0x10 }, { 0x04, 0x20 }, { 0x40, 0x80 } };
+
+	const int dots = frame.width * 2;
+	const int rows = frame.height * 4;
+	_captureDots.resize(static_cast<size_t>(dots) * rows);
+	AggregateBlocks(x0, y0, view.Block(), dots, rows, _captureDots.data());
+
+	for (int y = 0; y < frame.height; y++)
+	{
+		for (int x = 0; x < frame.width; x++)
+		{
+			uint8_t glyph = 0;
+			for (int r = 0; r < 4; r++)
 			{
-				cell.SetState(Cell::State::Dying);
+				const uint8_t* dot = &_captureDots[(static_cast<size_t>((y * 4) + r) * dots) + (x * 2)];
+				glyph |= (dot[0] ? dotBits[r][0] : 0) | (dot[1] ? dotBits[r][1] : 0);
 			}
+			frame.glyphs[x + (y * frame.width)] = glyph;
+		}
+	}
 }
 
-void Board::DayAndNightRules(Cell& cell) const
+void Board::Recount()
 {
-	// https://en.wikipedia.org/wiki/Day_and_Night_(cellular_automaton)
-	// rule notation B3678/S34678, meaning that a dead cell becomes live (is born)
-	// if it has 3, 6, 7, or 8 live neighbors, and a live cell remains alive (survives)
-	// if it has 3, 4, 6, 7, or 8 live neighbors,
-
-	static int count = 0;
-	count = cell.Neighbors();
-
-	if (cell.IsAlive() && ((count >= 3) && (count != 5)))
+	// the hash from scratch, and whatever the run did before doesn't lead here any more
+	_cycles.Reset();
+	if (OnPlane())
 	{
-		cell.SetState(Cell::State::Live);
+		// the planes already have it
+		_hash = PlaneHash();
 	}
-	else if (cell.IsDead() && (count == 3 || count >= 6))
+	else
 	{
-		cell.SetState(Cell::State::Born);
+		ForEachBand([this](int band, int y0, int y1)
+		{
+			uint64_t hash = 0;
+			for (int y = y0; y < y1; y++)
+			{
+				for (int x = 0; x < _width; x++)
+				{
+					const int i = Index(x, y);
+					const uint8_t state = (_engine == Engine::Packed) ? _bits.Get(x, y) : _front->state[i];
+					hash ^= Zobrist::Key(i, state);
+				}
+			}
+			_bandCounts[band].hash = hash;
+		});
+		_hash = BandHashes();
 	}
-	else if (cell.IsAlive())
+	_cycles.Record(_generation, _hash, IsEmpty());
+
+	if (_engine == Engine::Packed)
 	{
-		cell.SetState(Cell::State::Dying);
+		// counted straight from the bits when asked
+		return;
 	}
+
+	if (OnPlane())
+	{
+		const uint64_t inside = HasView() ? std::count(_view.begin(), _view.end(), uint8_t{ 1 }) : _life.Population(0, 0, _width, _height);
+		_counts = CellCounts();
+		_counts.live = static_cast<int>(std::min<uint64_t>(PlanePopulation(), std::numeric_limits<int>::max()));
+		_counts.dead = _size - static_cast<int>(inside);
+		return;
+	}
+
+	// live goes in live and fading cells in dying, just for the tally
+	ForEachBand([this](int band, int y0, int y1)
+	{
+		CellCounts& counts = _bandCounts[band].counts;
+		counts = CellCounts();
+		const auto begin = _front->state.begin() + (static_cast<size_t>(y0) * _width);
+		const auto end = _front->state.begin() + (static_cast<size_t>(y1) * _width);
+		counts.live = static_cast<int>(std::count(begin, end, uint8_t{ 1 }));
+		counts.dying = static_cast<int>(std::count_if(begin, end, [](uint8_t state) { return state > 1; }));
+	});
+	ReduceCounts();
+
+	_fading = _counts.dying;
+	_counts.dying = 0;
+	_counts.dead = _size - _counts.live - _fading;
 }
 
-void Board::LifeWithoutDeathRules(Cell& cell) const
+void Board::Settle()
 {
-	// https://en.wikipedia.org/wiki/Life_without_Death
-	// every cell that was alive in the previous pattern remains alive,
-	// every dead cell that has exactly 3 live neighbors becomes alive itself
-	// and every other dead cell remains dead. B3/S012345678
+	_pending = false;
+	if (_engine == Engine::Packed)
+	{
+		_bits.Tiles().MarkAllActive();
+		Recount();
+		return;
+	}
 
-	static int count = 0;
-	count = cell.Neighbors();
+	if (_engine == Engine::HashLife)
+	{
+		// the tree is the board, there's nothing else to bring up to date
+		Recount();
+		return;
+	}
 
-	if (cell.IsAlive())
+	if (_engine == Engine::Sparse)
 	{
-		cell.SetState(Cell::State::Live);
+		// a word at a time, and only the words with something in them make chunks
+		_plane.Clear();
+		std::vector<uint64_t> bits((static_cast<size_t>(_width) + 63) / 64);
+		for (int y = 0; y < _height; y++)
+		{
+			LiveRow(y, bits.data());
+			for (size_t w = 0; w < bits.size(); w++)
+			{
+				_plane.SetWord(static_cast<int64_t>(w) * 64, y, bits[w]);
+			}
+		}
+		_nextView = _view;
+		_viewChanged.clear();
+		Recount();
+		return;
 	}
-	else
-	if (cell.IsDead() && count == 3)
+
+	_tiles.MarkAllActive();
+	if (_engine == Engine::Incremental)
 	{
-		cell.SetState(Cell::State::Born);
+		// every count is stale, start over from the new cells
+		ForEachBand([this](int, int y0, int y1)
+		{
+			for (int i = y0 * _width; i < y1 * _width; i++)
+			{
+				int count = 0;
+				ForEachNeighbor(i, [this, &count](int n)
+				{
+					count += _front->state[n] == 1;
+				});
+				_neighbors[i] = static_cast<uint8_t>(count);
+			}
+		});
+		_changes.clear();
+		_sweep = true;
 	}
+	Recount();
 }
 
-void Board::HighlifeRules(Cell& cell) const
+void Board::Fill(double density, uint64_t seed)
 {
-	// https://en.wikipedia.org/wiki/Highlife_(cellular_automaton)
-	// the rule B36 / S23; that is, a cell is born if it has 3 or 6 neighbors
-	//and survives if it has 2 or 3 neighbors.
+	const uint32_t fraction = static_cast<uint32_t>(std::clamp(std::lround(density * 65536.0), 0L, 65536L));
+	const int words = (_width + 63) / 64;
 
-	static int count = 0;
-	count = cell.Neighbors();
-
-	if (cell.IsAlive() && count >= 2 && count <= 3)
+	// the tree gets built on one thread, a live cell at a time
+	if (_engine == Engine::HashLife)
 	{
-		cell.SetState(Cell::State::Live);
+		_life.Clear();
+		for (int y = 0; y < _height; y++)
+		{
+			for (int w = 0; w < words; w++)
+			{
+				for (uint64_t bits = SplitMix::Bits(seed, (static_cast<uint64_t>(y) * words) + w, fraction); bits != 0; bits &= bits - 1)
+				{
+					const int x = (w * 64) + std::countr_zero(bits);
+					if (x < _width)
+					{
+						_life.Set(x, y, true);
+					}
+				}
+			}
+		}
+		Settle();
+		return;
 	}
-	else
-	if (cell.IsDead() && ((count == 3) || (count == 6)))
+
+	// word w of row y is always counter (y * words) + w, whichever thread gets to it
+	ForEachBand([this, fraction, words, seed](int, int y0, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			for (int w = 0; w < words; w++)
+			{
+				const uint64_t counter = (static_cast<uint64_t>(y) * words) + w;
+				const uint64_t bits = SplitMix::Bits(seed, counter, fraction);
+				if (_engine == Engine::Packed)
+				{
+					_bits.SetWord(y, w, bits);
+					continue;
+				}
+
+				const int x0 = w * 64;
+				const int x1 = std::min(_width, x0 + 64);
+				const size_t row = static_cast<size_t>(y) * _width;
+				if (HasView())
+				{
+					for (int x = x0; x < x1; x++)
+					{
+						_view[row + x] = (bits >> (x & 63)) & 1;
+					}
+					continue;
+				}
+
+				// ages come from their own stream so they don't disturb which cells are live
+				for (int x = x0; x < x1; x++)
+				{
+					const uint8_t alive = (bits >> (x & 63)) & 1;
+					const int age = alive ? static_cast<int>(SplitMix::At(~seed, row + x) % 101) : 0;
+					_front->state[row + x] = alive;
+					_front->born[row + x] = static_cast<uint16_t>(_generation - age);
+				}
+			}
+		}
+	});
+
+	Settle();
+}
+
+void Board::Place(const Pattern& pattern, int x, int y)
+{
+	int cx = 0;
+	int cy = 0;
+	for (const char c : pattern.cells)
 	{
-		cell.SetState(Cell::State::Born);
+		if (c == '\n')
+		{
+			cx = 0;
+			cy++;
+			continue;
+		}
+
+		// HashLife and Sparse are planes, but the window onto them still wraps
+		int px = x + cx;
+		int py = y + cy;
+		if (c == 'O' && WrapCell(OnPlane() ? Topology::Torus : _topology, _width, _height, px, py))
+		{
+			SetCell(px, py, Cell::State::Live);
+		}
+		cx++;
 	}
-	else
-	if (cell.IsAlive())
+	Recount();
+}
+
+size_t Board::StateBytes(Layout layout) const
+{
+	if (layout == Layout::Bits)
 	{
-		cell.SetState(Cell::State::Dying);
+		return static_cast<size_t>(_height) * ((_width + 63) / 64) * sizeof(uint64_t);
 	}
+	return static_cast<size_t>(_size) * (sizeof(uint8_t) + sizeof(uint16_t));
 }
 
-void Board::SeedsRules(Cell& cell) const
+void Board::ExportState(std::vector<uint8_t>& out) const
 {
-	// https://en.wikipedia.org/wiki/Seeds_(cellular_automaton)
-	// In each time step, a cell turns on or is "born" if it was off or "dead"
-	// but had exactly two neighbors that were on
-	// all other cells turn off. It is described by the rule B2 / S
+	out.resize(StateBytes(StorageLayout()));
+	if (_engine == Engine::Packed)
+	{
+		std::memcpy(out.data(), _bits.Row(0), out.size());
+		return;
+	}
 
-	static int count = 0;
-	count = cell.Neighbors();
+	if (OnPlane())
+	{
+		const size_t words = (static_cast<size_t>(_width) + 63) / 64;
+		uint64_t* bits = reinterpret_cast<uint64_t*>(out.data());
+		for (int y = 0; y < _height; y++)
+		{
+			LiveRow(y, bits + (y * words));
+		}
+		return;
+	}
+
+	std::memcpy(out.data(), _front->state.data(), _size);
+	std::memcpy(out.data() + _size, _front->born.data(), _size * sizeof(uint16_t));
+}
 
-	if (cell.IsDead() && count == 2)
+bool Board::ImportState(Layout layout, const uint8_t* data, size_t bytes, int64_t generation)
+{
+	if (bytes != StateBytes(layout))
 	{
-		cell.SetState(Cell::State::Born);
+		return false;
 	}
-	else
+	_generation = generation;
+
+	// bits can be read one word at a time wherever they are, they might not be aligned
+	const int words = (_width + 63) / 64;
+	const auto word = [data, words](int y, int w)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, data + (((static_cast<size_t>(y) * words) + w) * sizeof(uint64_t)), sizeof(bits));
+		return bits;
+	};
+	const auto alive = [this, layout, data, &word](int x, int y) -> uint8_t
+	{
+		if (layout == Layout::Bits)
+		{
+			return (word(y, x >> 6) >> (x & 63)) & 1;
+		}
+		return data[Index(x, y)] == 1;
+	};
+
+	if (_engine == Engine::HashLife)
 	{
-		cell.SetState(Cell::State::Dying);
+		_life.Clear();
+		for (int y = 0; y < _height; y++)
+		{
+			for (int x = 0; x < _width; x++)
+			{
+				if (alive(x, y))
+				{
+					_life.Set(x, y, true);
+				}
+			}
+		}
+		Settle();
+		return true;
 	}
+
+	ForEachBand([this, layout, data, words, &word, &alive](int, int y0, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			const size_t row = static_cast<size_t>(y) * _width;
+			if (_engine == Engine::Packed)
+			{
+				for (int w = 0; w < words; w++)
+				{
+					uint64_t bits = 0;
+					for (int x = w * 64; layout == Layout::Cells && x < std::min(_width, (w * 64) + 64); x++)
+					{
+						bits |= static_cast<uint64_t>(alive(x, y)) << (x & 63);
+					}
+					_bits.SetWord(y, w, (layout == Layout::Bits) ? word(y, w) : bits);
+				}
+			}
+			else if (HasView())
+			{
+				for (int x = 0; x < _width; x++)
+				{
+					_view[row + x] = alive(x, y);
+				}
+			}
+			else if (layout == Layout::Cells)
+			{
+				// same layout, straight copy
+				std::memcpy(&_front->state[row], data + row, _width);
+				std::memcpy(&_front->born[row], data + _size + (row * sizeof(uint16_t)), _width * sizeof(uint16_t));
+			}
+			else
+			{
+				// the bits don't have ages, everybody was just born
+				for (int x = 0; x < _width; x++)
+				{
+					_front->state[row + x] = alive(x, y);
+					_front->born[row + x] = static_cast<uint16_t>(_generation);
+				}
+			}
+		}
+	});
+
+	Settle();
+	return true;
 }
 
-void Board::BriansBrainRules(Cell& cell) const
+uint64_t Board::Hash() const
 {
-	// https://en.wikipedia.org/wiki/Brian%27s_Brain
-	// In each time step, a cell turns on if it was off but had exactly two neighbors that were on,
-	// just like the birth rule for Seeds. All cells that were "on" go into the "dying" state,
-	// which is not counted as an "on" cell in the neighbor count, and prevents any cell from
-	// being born there. Cells that were in the dying state go into the off state.
-
-	static int count = 0;
-	count = cell.Neighbors();
+	uint64_t hash = 0xcbf29ce484222325;
+	if (!_pending && !HasCells())
+	{
+		// nothing is on its way in or out, so every cell is Live or Dead and a row of bits says which
+		std::vector<uint64_t> bits((static_cast<size_t>(_width) + 63) / 64);
+		for (int y = 0; y < _height; y++)
+		{
+			LiveRow(y, bits.data());
+			for (int x = 0; x < _width; x++)
+			{
+				hash ^= static_cast<uint8_t>(((bits[x >> 6] >> (x & 63)) & 1) ? Cell::State::Live : Cell::State::Dead);
+				hash *= 0x100000001b3;
+			}
+		}
+		return hash;
+	}
 
-	if (cell.IsDead() && count == 2)
+	for (int y = 0; y < _height; y++)
 	{
-		cell.SetState(Cell::State::Born);
+		for (int x = 0; x < _width; x++)
+		{
+			hash ^= static_cast<uint8_t>(GetCellState(x, y));
+			hash *= 0x100000001b3;
+		}
 	}
-	else
-	if (cell.GetState() == Cell::State::Live)
+	return hash;
+}
+
+int Board::GetLiveCount() const
+{
+	return (_engine == Engine::Packed) ? _bits.Population() : _counts.live;
+}
+
+int Board::GetDeadCount() const
+{
+	return (_engine == Engine::Packed) ? _size - _bits.Population() : _counts.dead;
+}
+
+int Board::GetBornCount() const
+{
+	if (_engine == Engine::Packed)
 	{
-		cell.SetState(Cell::State::Dying);
+		return _pending ? _bits.CountBorn() : 0;
 	}
-	else
-	if (cell.GetState() == Cell::State::Dying)
+	return _counts.born;
+}
+
+int Board::GetDyingCount() const
+{
+	if (_engine == Engine::Packed)
 	{
-		cell.SetState(Cell::State::Dead);
+		return _pending ? _bits.CountDying() : 0;
 	}
+	return _counts.dying;
+}
+
+int Board::GetOldCount() const
+{
+	// the packed engine doesn't track ages
+	return (_engine == Engine::Packed) ? 0 : _counts.old;
 }
@@ -1,19 +1,526 @@
 ﻿#pragma once
 #include "Cell.h"
+#include "BitBoard.h"
+#include "ThreadPool.h"
+#include "HashLife.h"
+#include "SparsePlane.h"
+#include "ActiveTiles.h"
+#include "Patterns.h"
+#include "ByteKernel.h"
+#include "Zobrist.h"
+#include "CycleDetector.h"
+#include "Statistics.h"
+#include "Topology.h"
+
+struct Frame;
+struct Viewport;
 
 // for visualization purposes (0,0) is the top left.
 // as x increases move right, as y increases move down
 class Board
 {
+public:
+    // Cells keeps state and age per position and runs any ruleset
+    // Packed keeps 64 cells per word and only runs plain B/S rules (no ages, no Brian's Brain)
+    // HashLife runs plain B/S rules on an unbounded plane, the board is just the window onto it,
+    // and can move 2^n generations per step
+    // Incremental is the Cells layout plus a live neighbor count per cell that gets patched whenever
+    // a cell flips, so a step only looks at cells next to last step's changes. runs any ruleset
+    // Sparse runs plain B/S rules on an unbounded plane of 64x64 chunks that only exist where there's life,
+    // the board is the window onto it like HashLife, but every step is one generation
+    enum class Engine { Cells, Packed, HashLife, Incremental, Sparse };
+
+    // how ExportState lays out the current generation
+    // Bits is the bit rows, padded to whole words like BitBoard. Cells is every state byte and then
+    // every born generation as a uint16. both are in the machine's byte order
+    enum class Layout { Bits, Cells };
+
 private:
-    // if I allocated this on the heap, I could get the size right with resize
-    std::vector<Cell> _board;
+    // one generation of the Cells engine, a compact array per field instead of an array of Cells
+    // states are the Rule states (0 dead, 1 live, 2 and up dying), Born, Old and the rest
+    // of the Cell::States are worked out from them and the age when somebody asks
+    // born is the (wrapped) generation a live cell was born in rather than its age, so a still life
+    // stores exactly the same thing every generation and its tile can be skipped
+    struct Buffer
+    {
+        std::vector<uint8_t> state;
+        std::vector<uint16_t> born;
+    };
+
+    // the rule pass reads _front and writes _back, NextGeneration swaps the pointers
+    Buffer _buffers[2];
+    Buffer* _front;
+    Buffer* _back;
+    // live neighbors each cell had when the rule pass last ran
+    // the Incremental engine keeps them up to date with the newest generation instead
+    std::vector<uint8_t> _neighbors;
+    // Incremental only. cells whose state changed in the last step or through SetCell,
+    // the cells to look at next step and whether they're already on that list
+    std::vector<int> _changes;
+    std::vector<int> _candidates;
+    std::vector<uint8_t> _queued;
+    // look at every cell next step, not just the ones around _changes
+    bool _sweep;
+    int _fading;
+    int _evaluated;
+    // which ActiveTiles::Size square tiles the next rule pass has to compute, and the live cells
+    // in each tile so skipped tiles still add up
+    ActiveTiles _tiles;
+    std::vector<int> _tileLive;
+    // the Cells rule pass walks the board a block of tiles at a time, every row of a block before the next one,
+    // so on a wide board the rows above and below are still in L1 when they get reused. a block is also
+    // the piece of work the pool hands out
+    struct Blocks
+    {
+        struct Span
+        {
+            int tx0;
+            int ty0;
+            int tx1;
+            int ty1;
+        };
+
+        // tiles per block
+        int tilesX = 1;
+        int tilesY = 1;
+        // blocks across and down
+        int columns = 1;
+        int rows = 1;
+
+        int Count() const
+        {
+            return columns * rows;
+        }
+
+        // the tiles in block, blocks go across and then down
+        Span Get(int block, int tileColumns, int tileRows) const
+        {
+            const int bx = block % columns;
+            const int by = block / columns;
+            return Span{ bx * tilesX, by * tilesY, std::min(tileColumns, (bx + 1) * tilesX), std::min(tileRows, (by + 1) * tilesY) };
+        }
+    };
+    Blocks _blocks;
+    // what the next Cells rule pass hands out, see UpdateBoard
+    std::vector<Blocks::Span> _spans;
+    // what SetBlockSize asked for, 0 for whatever suits the caches
+    int _blockWidth = 0;
+    int _blockHeight = 0;
+
+    // the rule the last pass ran, a different one can wake up tiles that looked settled
+    PackedRule _lastRule;
+    int _lastStates;
+
     int _width;
     int _height;
     int _size;
-    int _generation;
-    int _x;
-    int _y;
+    int64_t _generation;
+    Engine _engine;
+    Topology _topology;
+    // the ring of states just outside the Cells engine's board, refilled for the topology before every step
+    // so the rule pass never has to check for an edge. the rows have a corner on either end,
+    // row -1 is _haloAbove[x + 1], and the columns are the same height, row y is _haloLeft[y + 1]
+    std::vector<uint8_t> _haloAbove;
+    std::vector<uint8_t> _haloBelow;
+    std::vector<uint8_t> _haloLeft;
+    std::vector<uint8_t> _haloRight;
+    BitBoard _bits;
+    // HashLife keeps no copy of the window, whatever gets drawn or counted is read out of the tree when it's asked for
+    HashLife _life;
+    // the window onto the Sparse plane now and after the pending step, 1 for live
+    std::vector<uint8_t> _view;
+    std::vector<uint8_t> _nextView;
+    int _lifeStep;
+    std::optional<PackedRule> _lifeRule;
+    SparsePlane _plane;
+    // the plane chunks in the window the last step changed, the only places _nextView is behind _view
+    std::vector<SparsePlane::Coord> _viewChanged;
+    // true between UpdateBoard and NextGeneration, the back buffer holds the next generation
+    bool _pending;
+    // Zobrist hash of the current generation and of the one the pending step made,
+    // each step patches it with just the cells that changed. the planes hash all of the plane, not just the window,
+    // or a glider that flew off the window would look like the board froze
+    uint64_t _hash;
+    uint64_t _nextHash;
+    CycleDetector _cycles;
+    // a Sample for every generation, only when somebody asked for them with KeepHistory
+    History _history;
+
+    // one horizontal band of rows per worker, nullptr runs everything on the calling thread
+    std::unique_ptr<ThreadPool> _pool;
+
+    // per band tallies, padded so two bands never write to the same cache line
+    struct alignas(64) BandCounts
+    {
+        CellCounts counts;
+        uint64_t hash = 0;
+    };
+    std::vector<BandCounts> _bandCounts;
+    CellCounts _counts;
+
+    // a row of live bits per band for zoomed out captures
+    std::vector<std::vector<uint64_t>> _captureRows;
+
+    // what ByteKernel::Step reads and writes for a run of tiles, one per worker
+    // the three rows with the neighbors on either end, then the counts and next states
+    struct KernelRows
+    {
+        std::vector<uint8_t> halo[3];
+        std::vector<uint8_t> neighbors;
+        std::vector<uint8_t> nexts;
+    };
+    std::vector<KernelRows> _kernelRows;
+    std::vector<uint8_t> _captureDots;
+
+    int Bands() const
+    {
+        return _pool ? _pool->Size() : 1;
+    }
+
+    // first row of a band, the band ends where the next one starts
+    // bands start on a tile boundary so every tile belongs to exactly one band
+    int BandBegin(int band) const
+    {
+        if (band == Bands())
+        {
+            return _height;
+        }
+
+        const int64_t tileRows = (_height + ActiveTiles::Size - 1) / ActiveTiles::Size;
+        return static_cast<int>((tileRows * band) / Bands()) * ActiveTiles::Size;
+    }
+
+    // calls job(band, y0, y1) for every band, in parallel when there is a pool
+    void ForEachBand(const auto& job)
+    {
+        if (!_pool)
+        {
+            job(0, 0, _height);
+            return;
+        }
+
+        _pool->Run([this, &job](int band)
+        {
+            job(band, BandBegin(band), BandBegin(band + 1));
+        });
+    }
+
+    // splits [0, count) into a chunk per band and calls job(band, begin, end) for each, in parallel when there is a pool
+    void ForEachChunk(int count, const auto& job)
+    {
+        if (!_pool)
+        {
+            job(0, 0, count);
+            return;
+        }
+
+        _pool->Run([this, count, &job](int band)
+        {
+            const int begin = static_cast<int>((static_cast<int64_t>(count) * band) / Bands());
+            const int end = static_cast<int>((static_cast<int64_t>(count) * (band + 1)) / Bands());
+            job(band, begin, end);
+        });
+    }
+
+    // calls job(worker, task) for every task in [0, count), in parallel when there is a pool
+    // each worker starts on an even share and steals from the others once it runs out, so a few busy spots
+    // on an otherwise quiet board still get spread around. job adds its tallies to _bandCounts[worker]
+    void ForEachTask(int count, const auto& job)
+    {
+        if (!_pool)
+        {
+            for (int task = 0; task < count; task++)
+            {
+                job(0, task);
+            }
+            return;
+        }
+
+        _pool->RunTasks(count, [&job](int worker, int task)
+        {
+            job(worker, task);
+        });
+    }
+
+    // before a ForEachTask adds to them
+    void ClearBandCounts()
+    {
+        for (BandCounts& band : _bandCounts)
+        {
+            band = BandCounts();
+        }
+    }
+
+    void ReduceCounts();
+
+    // works out _blocks from the caches, the board, the thread count and SetBlockSize
+    void SizeBlocks();
+
+    // the bands' hash changes put together
+    uint64_t BandHashes() const
+    {
+        uint64_t hash = 0;
+        for (const BandCounts& band : _bandCounts)
+        {
+            hash ^= band.hash;
+        }
+        return hash;
+    }
+
+    // the cells were all rewritten at once, wakes every tile and rebuilds what's worked out from them
+    void Settle();
+
+    // ORs the live cells of rows [y0, y1) into bits, only the words covering columns [x0, x1)
+    void AccumulateRows(int y0, int y1, int x0, int x1, uint64_t* bits) const;
+
+    // for a rows by dots grid of block x block squares starting at board cell (x, y),
+    // whether anything in each square is alive
+    void AggregateBlocks(int x, int y, int block, int dots, int rows, uint8_t* out);
+
+    // every tile has to be looked at again when the rule changes
+    void WakeOnRuleChange(const auto& rule)
+    {
+        const PackedRule packed = rule.Packed();
+        if (packed.birth != _lastRule.birth || packed.survive != _lastRule.survive || rule.States() != _lastStates)
+        {
+            _tiles.MarkAllActive();
+            _bits.Tiles().MarkAllActive();
+            _plane.MarkAllChanged();
+            _sweep = true;
+            _lastRule = packed;
+            _lastStates = rule.States();
+        }
+    }
+
+    // the counts and hash after a HashLife step, from the tree's populations and root
+    // the Sparse plane only copies and counts the chunks that changed
+    void UpdateLifeCounts();
+    void UpdateSparseView();
+
+    uint64_t PlanePopulation() const
+    {
+        return (_engine == Engine::Sparse) ? _plane.Population() : _life.Population();
+    }
+
+    uint64_t PlaneHash() const
+    {
+        return (_engine == Engine::Sparse) ? _plane.Hash() : _life.Hash();
+    }
+
+    // what the cycle detector calls died out, the planes are only empty when nothing is left anywhere on them
+    bool IsEmpty() const
+    {
+        return OnPlane() ? PlanePopulation() == 0 : _hash == 0;
+    }
+
+    // hands the rule to HashLife, false if it can't run it
+    bool UseLifeRule(const auto& rule)
+    {
+        const PackedRule packed = rule.Packed();
+        if (!rule.IsPlain() || !HashLife::Supports(packed))
+        {
+            return false;
+        }
+
+        // changing the rule throws away everything HashLife remembered, so only do it when it changes
+        if (!_lifeRule || _lifeRule->birth != packed.birth || _lifeRule->survive != packed.survive)
+        {
+            _life.SetRule(packed);
+            _lifeRule = packed;
+        }
+        return true;
+    }
+
+    int Index(int x, int y) const
+    {
+        return x + (y * _width);
+    }
+
+    const uint8_t* StateRow(int y) const
+    {
+        return &_front->state[static_cast<size_t>(y) * _width];
+    }
+
+    bool HasCells() const
+    {
+        return _engine == Engine::Cells || _engine == Engine::Incremental;
+    }
+
+    // the cells live in a plane and the board is a window onto it
+    bool OnPlane() const
+    {
+        return _engine == Engine::HashLife || _engine == Engine::Sparse;
+    }
+
+    // the window is kept in _view
+    bool HasView() const
+    {
+        return _engine == Engine::Sparse;
+    }
+
+    // copies what the topology puts around the board into the halo, before the Cells rule pass
+    void FillHalo();
+
+    // calls f(index) for the neighbors of cell i, the topology decides what's past the edges
+    void ForEachNeighbor(int i, const auto& f) const
+    {
+        const int x = i % _width;
+        const int y = i / _width;
+        if (x > 0 && x < _width - 1 && y > 0 && y < _height - 1)
+        {
+            f(i - _width - 1);
+            f(i - _width);
+            f(i - _width + 1);
+            f(i - 1);
+            f(i + 1);
+            f(i + _width - 1);
+            f(i + _width);
+            f(i + _width + 1);
+            return;
+        }
+
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int nx = x + dx;
+                int ny = y + dy;
+                if ((dx != 0 || dy != 0) && WrapCell(_topology, _width, _height, nx, ny))
+                {
+                    f(Index(nx, ny));
+                }
+            }
+        }
+    }
+
+    // a cell became live or stopped being live, patch the counts around it
+    void AddNeighbor(int i, int delta)
+    {
+        ForEachNeighbor(i, [this, delta](int n)
+        {
+            _neighbors[n] = static_cast<uint8_t>(_neighbors[n] + delta);
+        });
+    }
+
+    // the Incremental rule pass, single threaded since it only touches a handful of cells
+    // only a cell whose neighborhood changed can change, so those are the only cells evaluated
+    void UpdateChanges(const auto& rule)
+    {
+        const int oldAge = Cell::GetOldAge();
+        const uint8_t aged = (rule.States() > 2) ? 2 : 0;
+        const uint16_t stamp = static_cast<uint16_t>(_generation + 1);
+
+        WakeOnRuleChange(rule);
+        // cells die of old age without anything around them changing
+        const bool sweep = _sweep || oldAge > 0;
+        _sweep = false;
+
+        _candidates.clear();
+        if (!sweep)
+        {
+            const auto queue = [this](int n)
+            {
+                if (!_queued[n])
+                {
+                    _queued[n] = 1;
+                    _candidates.push_back(n);
+                }
+            };
+
+            for (const int i : _changes)
+            {
+                queue(i);
+                ForEachNeighbor(i, queue);
+            }
+        }
+        _changes.clear();
+        _evaluated = sweep ? _size : static_cast<int>(_candidates.size());
+
+        // the back buffer matches the front everywhere except for last step's changes,
+        // and those are all candidates, so writing just the candidates leaves it complete
+        CellCounts counts;
+        uint64_t hash = 0;
+        const auto evaluate = [&](int i)
+        {
+            const uint8_t state = _front->state[i];
+            uint8_t next = rule.Next(state, _neighbors[i]);
+            const uint16_t born = (state != 1 && next == 1) ? stamp : _front->born[i];
+            const int age = (next == 1) ? static_cast<uint16_t>(stamp - born) : 0;
+            if (oldAge > 0 && next == 1 && age >= oldAge)
+            {
+                next = aged;
+            }
+
+            _back->state[i] = next;
+            _back->born[i] = born;
+            if (next != state)
+            {
+                _changes.push_back(i);
+                hash ^= Zobrist::Change(i, state, next);
+            }
+
+            _fading += (next > 1) - (state > 1);
+            counts.born += (next == 1) & (state != 1);
+            counts.dying += ((state == 1) & (next != 1)) | (next > 1);
+            counts.old += (oldAge > 0) & (next == 1) & (age >= oldAge - 2);
+            counts.live += (next == 1) - (state == 1);
+        };
+
+        if (sweep)
+        {
+            for (int i = 0; i < _size; i++)
+            {
+                evaluate(i);
+            }
+        }
+        else
+        {
+            for (const int i : _candidates)
+            {
+                evaluate(i);
+                _queued[i] = 0;
+            }
+        }
+
+        // only now, the counts had to describe the front while the candidates were evaluated
+        for (const int i : _changes)
+        {
+            const bool was = _front->state[i] == 1;
+            const bool is = _back->state[i] == 1;
+            if (was != is)
+            {
+                AddNeighbor(i, is ? 1 : -1);
+            }
+        }
+
+        counts.live += _counts.live;
+        counts.dead = _size - counts.live - _fading;
+        _counts = counts;
+        _nextHash = _hash ^ hash;
+        _pending = true;
+    }
+
+    // how old a live cell is in the generation stored in the buffer
+    static int Age(const Buffer& buffer, int i, int64_t generation)
+    {
+        return (buffer.state[i] == 1) ? static_cast<uint16_t>(generation - buffer.born[i]) : 0;
+    }
+
+    // what a stored state looks like as a Cell::State
+    static Cell::State DisplayState(uint8_t state, int age)
+    {
+        if (state == 0)
+        {
+            return Cell::State::Dead;
+        }
+
+        if (state == 1)
+        {
+            const int oldAge = Cell::GetOldAge();
+            return (oldAge > 0 && age >= oldAge - 2) ? Cell::State::Old : Cell::State::Live;
+        }
+        return Cell::State::Dying;
+    }
 
 public:
     Board(const Board& b) = delete;
@@ -21,13 +528,92 @@ public:
     ~Board() = default;
     Board const& operator=(Board& b) = delete;
 
-    Board(int width, int height);
+    Board(int width, int height, Engine engine = Engine::Cells);
+
+    Engine GetEngine() const
+    {
+        return _engine;
+    }
+
+    // 1 runs the serial path, more splits every pass into that many bands of rows
+    // either way the results are bit-identical
+    void SetThreads(int threads);
+
+    int Threads() const
+    {
+        return Bands();
+    }
+
+    // what each thread did in the rule passes since ResetWorkers, empty with only the one thread
+    // Incremental and HashLife don't hand out tasks so theirs stay at zero
+    std::vector<ThreadPool::WorkerStats> Workers() const
+    {
+        std::vector<ThreadPool::WorkerStats> workers;
+        for (int worker = 0; _pool && worker < _pool->Size(); worker++)
+        {
+            workers.push_back(_pool->Stats(worker));
+        }
+        return workers;
+    }
+
+    // wall time the workers' busyNs is out of
+    int64_t WorkersElapsedNs() const
+    {
+        return _pool ? _pool->ElapsedNs() : 0;
+    }
+
+    void ResetWorkers()
+    {
+        if (_pool)
+        {
+            _pool->ResetStats();
+        }
+    }
+
+    // how the Cells engine walks the board, in cells rounded to whole tiles. 0 sizes them from the L1 and L2 caches,
+    // and a block as wide as the board is the plain row by row walk
+    void SetBlockSize(int width, int height)
+    {
+        _blockWidth = std::max(width, 0);
+        _blockHeight = std::max(height, 0);
+        SizeBlocks();
+    }
+
+    int BlockWidth() const
+    {
+        return std::min(_width, _blocks.tilesX * ActiveTiles::Size);
+    }
+
+    int BlockHeight() const
+    {
+        return std::min(_height, _blocks.tilesY * ActiveTiles::Size);
+    }
 
-    int Generation() const
+    int64_t Generation() const
     {
         return _generation;
     }
 
+    // what's past the edges for the Cells, Packed and Incremental engines, HashLife and Sparse don't have any
+    // the cells stay as they are, only the counts and hashes start over
+    void SetTopology(Topology topology);
+
+    Topology GetTopology() const
+    {
+        return _topology;
+    }
+
+    // HashLife only, every UpdateBoard moves 2^log2 generations
+    void SetStepSize(int log2)
+    {
+        _lifeStep = std::max(log2, 0);
+    }
+
+    int64_t GenerationsPerStep() const
+    {
+        return (_engine == Engine::HashLife) ? (int64_t{ 1 } << _lifeStep) : 1;
+    }
+
     int Width() const
     {
         return _width;
@@ -38,64 +624,499 @@ public:
         return _height;
     }
 
-    void SetCell(int x, int y, Cell::State state)
+    // Born, Live and Old all store as live, Dying as dead. age only matters to the Cells engine
+    void SetCell(int x, int y, Cell::State state, int age = 0)
     {
         // no bounds checking
-        Cell& cell = GetCell(x, y);
-        cell.SetState(state);
+        const bool alive = state == Cell::State::Born || state == Cell::State::Live || state == Cell::State::Old;
+        const int i = Index(x, y);
+        _cycles.Reset();
+        if (_engine == Engine::Packed)
+        {
+            _hash ^= Zobrist::Change(i, _bits.Get(x, y), alive);
+            _bits.Set(x, y, alive);
+            return;
+        }
+
+        if (_engine == Engine::HashLife)
+        {
+            _life.Set(x, y, alive);
+            _hash = _life.Hash();
+            return;
+        }
+
+        if (_engine == Engine::Sparse)
+        {
+            // both views, UpdateSparseView only brings _nextView up to date where the plane changed
+            _plane.Set(x, y, alive);
+            _hash = _plane.Hash();
+            _view[i] = alive ? 1 : 0;
+            _nextView[i] = _view[i];
+            return;
+        }
+
+        const uint8_t was = _front->state[i];
+        _hash ^= Zobrist::Change(i, was, alive);
+        _front->state[i] = alive ? 1 : 0;
+        _front->born[i] = static_cast<uint16_t>(_generation - age);
+        _tiles.MarkAllActive();
+
+        if (_engine == Engine::Incremental && _front->state[i] != was)
+        {
+            if (alive || was == 1)
+            {
+                AddNeighbor(i, alive ? 1 : -1);
+                _counts.live += alive ? 1 : -1;
+            }
+            _fading -= was > 1;
+            _changes.push_back(i);
+        }
     }
 
-    const Cell& GetCell(int x, int y) const
+    // works for every engine, a pending generation shows up as Born and Dying
+    Cell::State GetCellState(int x, int y) const
     {
-        // no bounds checking
-        return _board[x + (y * _width)];
+        const int i = Index(x, y);
+        if (_engine == Engine::HashLife)
+        {
+            // a pending step is already in the tree, which still has the generation before it
+            const bool next = _life.Get(x, y);
+            const bool alive = _pending ? _life.GetPrevious(x, y) : next;
+            if (alive != next)
+            {
+                return alive ? Cell::State::Dying : Cell::State::Born;
+            }
+            return alive ? Cell::State::Live : Cell::State::Dead;
+        }
+
+        if (!HasCells())
+        {
+            const bool alive = (_engine == Engine::Packed) ? _bits.Get(x, y) : _view[i] != 0;
+            const bool next = !_pending ? alive : (_engine == Engine::Packed) ? _bits.GetNext(x, y) : _nextView[i] != 0;
+            if (alive != next)
+            {
+                return alive ? Cell::State::Dying : Cell::State::Born;
+            }
+            return alive ? Cell::State::Live : Cell::State::Dead;
+        }
+
+        if (!_pending)
+        {
+            return DisplayState(_front->state[i], Age(*_front, i, _generation));
+        }
+
+        const uint8_t now = _front->state[i];
+        const uint8_t next = _back->state[i];
+        if (now == 1 && next != 1)
+        {
+            return Cell::State::Dying;
+        }
+        if (now != 1 && next == 1)
+        {
+            return Cell::State::Born;
+        }
+        return DisplayState(next, Age(*_back, i, _generation + 1));
     }
 
-    Cell& GetCell(int x, int y)
+    int GetLiveCount() const;
+
+    int GetDeadCount() const;
+
+    int GetBornCount() const;
+
+    int GetDyingCount() const;
+
+    int GetOldCount() const;
+
+    // the fraction of the board the last step actually had to compute
+    double GetActiveRatio() const
     {
-        // no bounds checking
-        return _board[x + (y * _width)];
+        switch (_engine)
+        {
+        case Engine::Cells:
+            return _tiles.ActiveRatio();
+        case Engine::Packed:
+            return _bits.Tiles().ActiveRatio();
+        case Engine::Incremental:
+            return static_cast<double>(_evaluated) / static_cast<double>(_size);
+        case Engine::Sparse:
+            return _plane.ActiveRatio();
+        default:
+            return 1.0;
+        }
     }
 
-    Cell& CurrentCell()
+    void NextGeneration();
+
+    // copies what's in the viewport, pending fates included, for drawing on another thread
+    // zoomed out views work off the current generation and run on the thread pool
+    void Capture(Frame& frame, const Viewport& view);
+
+    // clears the board and makes each cell live with probability density, the same seed always fills
+    // every engine the same way whatever the thread count. one pass, 64 cells per random word
+    void Fill(double density, uint64_t seed);
+
+    // counts from scratch, call it after a batch of SetCell so the HUD catches up. nothing is born or dying yet
+    void Recount();
+
+    // the live cells of row y of the current generation, cell x is bit (x % 64) of bits[x / 64]
+    void LiveRow(int y, uint64_t* bits) const
     {
-        return _board[_x + (_y * _width)];
+        AccumulateRows(y, y + 1, 0, _width, bits);
     }
 
-    int CountLiveAndDyingNeighbors(Cell& cell);
+    // sets the live cells of pattern with its top left at (x, y), the topology decides what happens past the edges
+    void Place(const Pattern& pattern, int x, int y);
 
-    int CountLiveNotDyingNeighbors(Cell& cell);
+    Layout StorageLayout() const
+    {
+        return (_engine == Engine::Packed || OnPlane()) ? Layout::Bits : Layout::Cells;
+    }
 
-    void NextGeneration();
+    // size of the current generation in layout
+    size_t StateBytes(Layout layout) const;
+
+    // copies the current generation out as StorageLayout()
+    void ExportState(std::vector<uint8_t>& out) const;
+
+    // replaces the board with what ExportState wrote at generation, from a board of the same size
+    // any engine takes either layout, Bits into Cells starts every cell at age 0
+    // false if bytes is the wrong size for layout
+    bool ImportState(Layout layout, const uint8_t* data, size_t bytes, int64_t generation);
+
+    // hash of the current generation, kept up to date by every step, 0 for an empty board.
+    // the window's Zobrist hash, or the whole plane's for HashLife and Sparse
+    uint64_t StateHash() const
+    {
+        return _hash;
+    }
+
+    // remember a Sample for each of the last generations, 0 stops keeping them
+    // each one costs a look for the live cells' bounds on every step
+    void KeepHistory(size_t generations)
+    {
+        _history = History(generations);
+    }
+
+    const History& GetHistory() const
+    {
+        return _history;
+    }
+
+    // the current generation's counts and bounds, worked out now
+    Sample TakeSample() const
+    {
+        Sample sample;
+        sample.generation = _generation;
+        sample.counts.live = GetLiveCount();
+        sample.counts.dead = GetDeadCount();
+        sample.counts.born = GetBornCount();
+        sample.counts.dying = GetDyingCount();
+        sample.counts.old = GetOldCount();
+        sample.bounds = LiveBounds();
+        return sample;
+    }
 
-    void RandomizeBoard(int n);
+    // only rows and columns outside what's been found so far get looked at, after the first and last live rows
+    Bounds LiveBounds() const;
 
-    // This form does not work: void UpdateBoard(std::function<void(Cell& cell)>& F)
-    // but using auto is magic
-    void UpdateBoard(auto F)
+    // what the hashes say about the run so far
+    const CycleDetector& Cycles() const
     {
-        for (int y = 0; y < Height(); y++)
+        return _cycles;
+    }
+
+    // FNV-1a over the state of every cell, equal boards hash the same whatever the engine
+    uint64_t Hash() const;
+
+    // rule is a Rule, or one of the compile time Rules:: whose table the compiler can inline
+    // the packed, HashLife and Sparse engines only run plain B/S rules and leave the board alone for anything else
+    void UpdateBoard(const auto& rule)
+    {
+        if (_engine == Engine::Packed)
         {
-            for (int x = 0; x < Width(); x++)
+            if (rule.IsPlain())
             {
-                Cell& cc = GetCell(x, y);
-                CountLiveAndDyingNeighbors(cc);
-                F(cc);
-                cc.KillOldCell();
+                WakeOnRuleChange(rule);
+                const PackedRule packed = rule.Packed();
+                _bits.FillHalo();
+
+                // a row of tiles at a time
+                ClearBandCounts();
+                ForEachTask(_bits.Tiles().Rows(), [this, &packed](int worker, int ty)
+                {
+                    const int y0 = ty * ActiveTiles::Size;
+                    _bandCounts[worker].hash ^= _bits.StepRows(packed, y0, std::min(_height, y0 + ActiveTiles::Size));
+                });
+                _bits.Tiles().Update();
+                _nextHash = _hash ^ BandHashes();
+                _pending = true;
             }
+            return;
         }
-    }
-    void ConwayRules(Cell& cell) const;
 
-    void DayAndNightRules(Cell& cell) const;
+        if (_engine == Engine::HashLife)
+        {
+            if (UseLifeRule(rule))
+            {
+                _life.Step(_lifeStep);
+                UpdateLifeCounts();
+                _pending = true;
+            }
+            return;
+        }
+
+        if (_engine == Engine::Sparse)
+        {
+            const PackedRule packed = rule.Packed();
+            if (rule.IsPlain() && SparsePlane::Supports(packed))
+            {
+                WakeOnRuleChange(rule);
+                _plane.Prepare();
+                constexpr int chunksPerTask = 16;
+                ForEachTask((_plane.Chunks() + chunksPerTask - 1) / chunksPerTask, [this, &packed](int, int task)
+                {
+                    const int begin = task * chunksPerTask;
+                    _plane.StepChunks(packed, begin, std::min(_plane.Chunks(), begin + chunksPerTask));
+                });
+                _plane.Finish();
+                UpdateSparseView();
+                _pending = true;
+            }
+            return;
+        }
+
+        if (_engine == Engine::Incremental)
+        {
+            UpdateChanges(rule);
+            return;
+        }
+
+        const int oldAge = Cell::GetOldAge();
+        // where a cell goes when it dies of old age, Generations rules let it fade out
+        const uint8_t aged = (rule.States() > 2) ? 2 : 0;
+        // the wrapped generation being computed, what new cells get stamped with
+        const uint16_t stamp = static_cast<uint16_t>(_generation + 1);
+
+        WakeOnRuleChange(rule);
+        if (oldAge > 0)
+        {
+            // cells die of old age without anything around them changing
+            _tiles.MarkAllActive();
+        }
+
+        // reads only _front and writes only _back, so the blocks can go in any order and on any thread
+        // a skipped tile is already right in _back because it was the same the last two generations
+        const ByteKernel::Table table = ByteKernel::Table::Make(rule);
+        FillHalo();
+
+        // a block with anything to compute is a task per row of tiles, so a busy spot splits into pieces
+        // other workers can steal. a quiet one is a single task that only adds up its tiles.
+        // either way the tiles go in the same order, a block at a time
+        _spans.clear();
+        for (int block = 0; block < _blocks.Count(); block++)
+        {
+            const Blocks::Span span = _blocks.Get(block, _tiles.Columns(), _tiles.Rows());
+            bool active = false;
+            for (int ty = span.ty0; ty < span.ty1 && !active; ty++)
+            {
+                for (int tx = span.tx0; tx < span.tx1 && !active; tx++)
+                {
+                    active = _tiles.IsActive(tx, ty);
+                }
+            }
+
+            for (int ty = span.ty0; active && ty < span.ty1; ty++)
+            {
+                _spans.push_back(Blocks::Span{ span.tx0, ty, span.tx1, ty + 1 });
+            }
+            if (!active)
+            {
+                _spans.push_back(span);
+            }
+        }
+
+        ClearBandCounts();
+        _kernelRows.resize(Bands());
+        ForEachTask(static_cast<int>(_spans.size()), [this, &table, oldAge, aged, stamp](int worker, int task)
+        {
+            CellCounts counts;
+            int fading = 0;
+            uint64_t hash = 0;
+
+            const Blocks::Span& span = _spans[task];
+
+            // a run of active tiles goes through the kernel in one go, the vector kernels do far better on a long row
+            KernelRows& kernel = _kernelRows[worker];
+            const int spanWidth = std::min(_width, span.tx1 * ActiveTiles::Size) - (span.tx0 * ActiveTiles::Size);
+            for (std::vector<uint8_t>& halo : kernel.halo)
+            {
+                halo.resize(static_cast<size_t>(spanWidth) + 2);
+            }
+            kernel.neighbors.resize(spanWidth);
+            kernel.nexts.resize(spanWidth);
+
+            const int y0 = span.ty0 * ActiveTiles::Size;
+            const int y1 = std::min(_height, span.ty1 * ActiveTiles::Size);
+            for (int y = y0; y < y1; y++)
+            {
+                // past the top and bottom are the halo rows
+                const uint8_t* above = (y == 0) ? &_haloAbove[1] : StateRow(y - 1);
+                const uint8_t* row = StateRow(y);
+                const uint8_t* below = (y == _height - 1) ? &_haloBelow[1] : StateRow(y + 1);
+                const int ty = y / ActiveTiles::Size;
 
-    void LifeWithoutDeathRules(Cell& cell) const;
+                for (int runBegin = span.tx0; runBegin < span.tx1; runBegin++)
+                {
+                    if (!_tiles.IsActive(runBegin, ty))
+                    {
+                        continue;
+                    }
 
-    void HighlifeRules(Cell& cell) const;
+                    int runEnd = runBegin + 1;
+                    while (runEnd < span.tx1 && _tiles.IsActive(runEnd, ty))
+                    {
+                        runEnd++;
+                    }
 
-    void SeedsRules(Cell& cell) const;
+                    const int runX0 = runBegin * ActiveTiles::Size;
+                    const int runX1 = std::min(_width, runEnd * ActiveTiles::Size);
+                    const int runN = runX1 - runX0;
+                    const uint8_t* rows[3] = { above, row, below };
+                    for (int r = 0; r < 3; r++)
+                    {
+                        // row y - 1 + r of the board, so y + r in the halo columns
+                        uint8_t* halo = kernel.halo[r].data();
+                        halo[0] = (runX0 == 0) ? _haloLeft[y + r] : rows[r][runX0 - 1];
+                        std::memcpy(&halo[1], rows[r] + runX0, runN);
+                        halo[runN + 1] = (runX1 == _width) ? _haloRight[y + r] : rows[r][runX1];
+                    }
+                    ByteKernel::Step(table, &kernel.halo[0][1], &kernel.halo[1][1], &kernel.halo[2][1], runN, kernel.neighbors.data(), kernel.nexts.data());
 
-    void BriansBrainRules(Cell& cell) const;
-    void PrintBoard();
+                    // then the tiles one by one, they each keep their own tallies
+                    for (int tx = runBegin; tx < runEnd; tx++)
+                    {
+                        int& tileLive = _tileLive[tx + (ty * _tiles.Columns())];
+                        if (y % ActiveTiles::Size == 0)
+                        {
+                            tileLive = 0;
+                        }
+
+                        const int x0 = tx * ActiveTiles::Size;
+                        const int x1 = std::min(_width, x0 + ActiveTiles::Size);
+                        const int n = x1 - x0;
+                        const uint8_t* neighbors = kernel.neighbors.data() + (x0 - runX0);
+                        const uint8_t* nexts = kernel.nexts.data() + (x0 - runX0);
+
+                        // the kernel did the neighbors and the rule, ages and tallies are left
+                        uint8_t changed = 0;
+                        if (oldAge <= 0)
+                        {
+                            // nobody dies of old age so the kernel's states stand, and this loop vectorizes
+                            const int i0 = Index(x0, y);
+                            std::memcpy(&_back->state[i0], nexts, n);
+                            std::memcpy(&_neighbors[i0], neighbors, n);
+                            const uint8_t* states = row + x0;
+                            const uint16_t* bornBefore = &_front->born[i0];
+                            uint16_t* bornAfter = &_back->born[i0];
+
+                            int live = 0;
+                            int fade = 0;
+                            int births = 0;
+                            int deaths = 0;
+                            for (int k = 0; k < n; k++)
+                            {
+                                const uint8_t state = states[k];
+                                const uint8_t next = nexts[k];
+                                const int birth = (state != 1) & (next == 1);
+                                bornAfter[k] = birth ? stamp : bornBefore[k];
+                                changed |= next ^ state;
+                                live += next == 1;
+                                fade += next > 1;
+                                births += birth;
+                                deaths += ((state == 1) & (next != 1)) | (next > 1);
+                            }
+                            tileLive += live;
+                            fading += fade;
+                            counts.born += births;
+                            counts.dying += deaths;
+                        }
+                        for (int x = x0; oldAge > 0 && x < x1; x++)
+                        {
+                            const int i = Index(x, y);
+                            const uint8_t state = row[x];
+                            const int count = neighbors[x - x0];
+
+                            uint8_t next = nexts[x - x0];
+                            const uint16_t born = (state != 1 && next == 1) ? stamp : _front->born[i];
+                            const int age = (next == 1) ? static_cast<uint16_t>(stamp - born) : 0;
+                            if (oldAge > 0 && next == 1 && age >= oldAge)
+                            {
+                                next = aged;
+                            }
+
+                            _back->state[i] = next;
+                            _back->born[i] = born;
+                            _neighbors[i] = static_cast<uint8_t>(count);
+                            changed |= next ^ state;
+
+                            tileLive += next == 1;
+                            fading += next > 1;
+                            counts.born += (next == 1) & (state != 1);
+                            counts.dying += ((state == 1) & (next != 1)) | (next > 1);
+                            counts.old += (oldAge > 0) & (next == 1) & (age >= oldAge - 2);
+                        }
+
+                        if (changed)
+                        {
+                            _tiles.MarkChanged(tx, ty);
+
+                            const int i0 = Index(x0, y);
+                            for (int k = 0; k < n; k++)
+                            {
+                                hash ^= Zobrist::Change(i0 + k, row[x0 + k], _back->state[i0 + k]);
+                            }
+                        }
+                    }
+                    // runEnd is past the span or a quiet tile, so the ++ doesn't skip anything
+                    runBegin = runEnd;
+                }
+            }
+
+            // skipped tiles still count, nothing in them is born, dying or old
+            for (int ty = span.ty0; ty < span.ty1; ty++)
+            {
+                for (int tx = span.tx0; tx < span.tx1; tx++)
+                {
+                    counts.live += _tileLive[tx + (ty * _tiles.Columns())];
+                }
+            }
+            const int cells = spanWidth * (y1 - y0);
+            counts.dead = cells - counts.live - fading;
+            _bandCounts[worker].counts += counts;
+            _bandCounts[worker].hash ^= hash;
+        });
+
+        _tiles.Update();
+        ReduceCounts();
+        _nextHash = _hash ^ BandHashes();
+        _pending = true;
+    }
+
+    // HashLife only, jumps straight to Generation() + generations in log(generations) steps
+    void Advance(const auto& rule, int64_t generations)
+    {
+        if (_engine != Engine::HashLife || generations <= 0 || !UseLifeRule(rule))
+        {
+            return;
+        }
+
+        // nothing in between was looked at, so there's no born or dying to show, and any cycle the
+        // detector was following is as good as gone. Recount starts both over from the new plane
+        _life.Advance(static_cast<uint64_t>(generations));
+        _generation += generations;
+        _pending = false;
+        Recount();
+    }
 };
 
@@ -0,0 +1,260 @@
+﻿#include "pch.h"
+#include "ByteKernel.h"
+
+// the vector kernels only exist on x86, __attribute__((target)) lets gcc and clang build them without -mavx2
+#if defined(_M_X64) || defined(__x86_64__)
+#define BYTEKERNEL_X86 1
+#if defined(__GNUC__)
+#define BYTEKERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BYTEKERNEL_TARGET(isa)
+#endif
+#endif
+
+namespace
+{
+	using StepFunction = void (*)(const ByteKernel::Table&, const uint8_t*, const uint8_t*, const uint8_t*, int, uint8_t*, uint8_t*);
+
+	void Scalar(const ByteKernel::Table& table, const uint8_t* above, const uint8_t* row, const uint8_t* below, int n, uint8_t* counts, uint8_t* next)
+	{
+		// two plain loops, the compiler vectorizes the first one on its own
+		for (int x = 0; x < n; x++)
+		{
+			counts[x] = static_cast<uint8_t>((above[x - 1] == 1) + (above[x] == 1) + (above[x + 1] == 1) +
+				(row[x - 1] == 1) + (row[x + 1] == 1) +
+				(below[x - 1] == 1) + (below[x] == 1) + (below[x + 1] == 1));
+		}
+
+		for (int x = 0; x < n; x++)
+		{
+			const uint8_t state = row[x];
+			const uint8_t dying = (state + 1 < table.states) ? static_cast<uint8_t>(state + 1) : 0;
+			next[x] = (state == 0) ? table.birth[counts[x]] : (state == 1) ? table.survive[counts[x]] : dying;
+		}
+	}
+
+#ifdef BYTEKERNEL_X86
+	// the vector kernels go through a row this many cells at a time, so the column sums fit on the stack
+	constexpr int Chunk = 256;
+
+	// live cells in each column of the three rows, sums[i] for column x - 1 + i, i in [begin, end)
+	void ColumnSums(const uint8_t* above, const uint8_t* row, const uint8_t* below, int x, int begin, int end, uint8_t* sums)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			const int column = x - 1 + i;
+			sums[i] = static_cast<uint8_t>((above[column] == 1) + (row[column] == 1) + (below[column] == 1));
+		}
+	}
+
+	// cells [x + begin, x + end) from the column sums, the vector loops' leftovers
+	void FinishChunk(const ByteKernel::Table& table, const uint8_t* row, const uint8_t* sums, int x, int begin, int end, uint8_t* counts, uint8_t* next)
+	{
+		for (int k = begin; k < end; k++)
+		{
+			const uint8_t state = row[x + k];
+			const uint8_t count = static_cast<uint8_t>(sums[k] + sums[k + 1] + sums[k + 2] - (state == 1));
+			const uint8_t dying = (state + 1 < table.states) ? static_cast<uint8_t>(state + 1) : 0;
+			counts[x + k] = count;
+			next[x + k] = (state == 0) ? table.birth[count] : (state == 1) ? table.survive[count] : dying;
+		}
+	}
+
+	// all ones where the cell is live (state 1), so subtracting it counts
+	BYTEKERNEL_TARGET("sse4.1")
+	inline __m128i Live(const uint8_t* cells, __m128i one)
+	{
+		return _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cells)), one);
+	}
+
+	BYTEKERNEL_TARGET("avx2")
+	inline __m256i Live(const uint8_t* cells, __m256i one)
+	{
+		return _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells)), one);
+	}
+
+	// both vector kernels add the three rows up a column at a time first, then each count is three neighboring
+	// column sums less the cell itself: four compares a vector instead of eight
+	BYTEKERNEL_TARGET("sse4.1")
+	void Sse41(const ByteKernel::Table& table, const uint8_t* above, const uint8_t* row, const uint8_t* below, int n, uint8_t* counts, uint8_t* next)
+	{
+		const __m128i one = _mm_set1_epi8(1);
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i birth = _mm_load_si128(reinterpret_cast<const __m128i*>(table.birth));
+		const __m128i survive = _mm_load_si128(reinterpret_cast<const __m128i*>(table.survive));
+		const __m128i last = _mm_set1_epi8(static_cast<char>(table.states - 1));
+		alignas(16) uint8_t sums[Chunk + 2];
+
+		for (int x = 0; x < n; x += Chunk)
+		{
+			const int m = std::min(Chunk, n - x);
+			int i = 0;
+			for (; i + 16 <= m + 2; i += 16)
+			{
+				const __m128i sum = _mm_sub_epi8(_mm_sub_epi8(_mm_sub_epi8(zero, Live(above + x - 1 + i, one)), Live(row + x - 1 + i, one)), Live(below + x - 1 + i, one));
+				_mm_store_si128(reinterpret_cast<__m128i*>(sums + i), sum);
+			}
+			ColumnSums(above, row, below, x, i, m + 2, sums);
+
+			int k = 0;
+			for (; k + 16 <= m; k += 16)
+			{
+				const __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + k));
+				__m128i count = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + k)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + k + 1)));
+				count = _mm_add_epi8(count, _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + k + 2)));
+				count = _mm_add_epi8(count, _mm_cmpeq_epi8(state, one));
+
+				// dying cells count up and wrap to dead after the last state
+				__m128i dying = _mm_add_epi8(state, one);
+				dying = _mm_and_si128(dying, _mm_cmpeq_epi8(_mm_min_epu8(dying, last), dying));
+
+				__m128i result = _mm_blendv_epi8(dying, _mm_shuffle_epi8(survive, count), _mm_cmpeq_epi8(state, one));
+				result = _mm_blendv_epi8(result, _mm_shuffle_epi8(birth, count), _mm_cmpeq_epi8(state, zero));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(counts + x + k), count);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(next + x + k), result);
+			}
+			FinishChunk(table, row, sums, x, k, m, counts, next);
+		}
+	}
+
+	BYTEKERNEL_TARGET("avx2")
+	void Avx2(const ByteKernel::Table& table, const uint8_t* above, const uint8_t* row, const uint8_t* below, int n, uint8_t* counts, uint8_t* next)
+	{
+		const __m256i one = _mm256_set1_epi8(1);
+		const __m256i zero = _mm256_setzero_si256();
+		// pshufb looks up within each 128 bit lane, so both lanes get the table
+		const __m256i birth = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table.birth)));
+		const __m256i survive = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table.survive)));
+		const __m256i last = _mm256_set1_epi8(static_cast<char>(table.states - 1));
+		alignas(32) uint8_t sums[Chunk + 2];
+
+		for (int x = 0; x < n; x += Chunk)
+		{
+			const int m = std::min(Chunk, n - x);
+			int i = 0;
+			for (; i + 32 <= m + 2; i += 32)
+			{
+				const __m256i sum = _mm256_sub_epi8(_mm256_sub_epi8(_mm256_sub_epi8(zero, Live(above + x - 1 + i, one)), Live(row + x - 1 + i, one)), Live(below + x - 1 + i, one));
+				_mm256_store_si256(reinterpret_cast<__m256i*>(sums + i), sum);
+			}
+			ColumnSums(above, row, below, x, i, m + 2, sums);
+
+			int k = 0;
+			for (; k + 32 <= m; k += 32)
+			{
+				const __m256i state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + k));
+				__m256i count = _mm256_add_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + k)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + k + 1)));
+				count = _mm256_add_epi8(count, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + k + 2)));
+				count = _mm256_add_epi8(count, _mm256_cmpeq_epi8(state, one));
+
+				__m256i dying = _mm256_add_epi8(state, one);
+				dying = _mm256_and_si256(dying, _mm256_cmpeq_epi8(_mm256_min_epu8(dying, last), dying));
+
+				__m256i result = _mm256_blendv_epi8(dying, _mm256_shuffle_epi8(survive, count), _mm256_cmpeq_epi8(state, one));
+				result = _mm256_blendv_epi8(result, _mm256_shuffle_epi8(birth, count), _mm256_cmpeq_epi8(state, zero));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(counts + x + k), count);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(next + x + k), result);
+			}
+			FinishChunk(table, row, sums, x, k, m, counts, next);
+		}
+	}
+
+	// AVX2 needs the OS to save the ymm registers too, not just the CPU to have them
+	bool HasAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] >> 27) & 1;
+		if (!osxsave || (_xgetbv(0) & 6) != 6)
+		{
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] >> 5) & 1;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool HasSse41()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] >> 19) & 1;
+#else
+		return __builtin_cpu_supports("sse4.1");
+#endif
+	}
+#endif
+
+	ByteKernel::Level Best()
+	{
+#ifdef BYTEKERNEL_X86
+#if defined(__GNUC__)
+		// this runs before main, the CPU info may not be set up yet
+		__builtin_cpu_init();
+#endif
+		if (HasAvx2())
+		{
+			return ByteKernel::Level::Avx2;
+		}
+		if (HasSse41())
+		{
+			return ByteKernel::Level::Sse41;
+		}
+#endif
+		return ByteKernel::Level::Scalar;
+	}
+
+	StepFunction Function(ByteKernel::Level level)
+	{
+		switch (level)
+		{
+#ifdef BYTEKERNEL_X86
+		case ByteKernel::Level::Avx2: return Avx2;
+		case ByteKernel::Level::Sse41: return Sse41;
+#endif
+		default: return Scalar;
+		}
+	}
+
+	// picked once, before any simulation thread is running
+	ByteKernel::Level s_level = Best();
+	StepFunction s_step = Function(s_level);
+}
+
+ByteKernel::Level ByteKernel::Active()
+{
+	return s_level;
+}
+
+void ByteKernel::Force(Level level)
+{
+	s_level = std::min(level, Best());
+	s_step = Function(s_level);
+}
+
+std::string_view ByteKernel::Name(Level level)
+{
+	switch (level)
+	{
+	case Level::Avx2: return "avx2";
+	case Level::Sse41: return "sse4.1";
+	case Level::Scalar: return "scalar";
+	}
+	return "unknown";
+}
+
+void ByteKernel::Step(const Table& table, const uint8_t* above, const uint8_t* row, const uint8_t* below, int n, uint8_t* counts, uint8_t* next)
+{
+	s_step(table, above, row, below, n, counts, next);
+}
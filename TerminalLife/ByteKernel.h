@@ -0,0 +1,45 @@
+﻿#pragma once
+
+// the Cells engine's inner loop, a row of cells at a time, as wide as the CPU goes
+// AVX2 does 32 cells per step, SSE4.1 16, and anything else (ARM included) gets the plain loop
+// the rows are padded: cell -1 and cell n are the halo, the wrapped neighbors copied in by the caller,
+// so nothing in here has to know about the edges of the board
+class ByteKernel
+{
+public:
+    enum class Level { Scalar, Sse41, Avx2 };
+
+    // a Rule (or Rules::) boiled down to what the vector lookup needs
+    // dead cells go through birth, live ones through survive, both indexed by live neighbors,
+    // and dying ones just step towards 0 whatever is around them
+    struct Table
+    {
+        alignas(16) uint8_t birth[16];
+        alignas(16) uint8_t survive[16];
+        uint8_t states;
+
+        static Table Make(const auto& rule)
+        {
+            Table table{};
+            for (int count = 0; count < 9; count++)
+            {
+                table.birth[count] = rule.Next(0, count);
+                table.survive[count] = rule.Next(1, count);
+            }
+            table.states = static_cast<uint8_t>(rule.States());
+            return table;
+        }
+    };
+
+    // the best the CPU can do, unless Force picked something else
+    static Level Active();
+
+    // for comparing the kernels, anything the CPU can't do falls back to the best it can
+    static void Force(Level level);
+
+    static std::string_view Name(Level level);
+
+    // counts[x] is the live (state 1) neighbors of cell x and next[x] its state next generation
+    // above, row and below point at cell 0 of rows with a halo cell at -1 and n
+    static void Step(const Table& table, const uint8_t* above, const uint8_t* row, const uint8_t* below, int n, uint8_t* counts, uint8_t* next);
+};
@@ -0,0 +1,68 @@
+﻿#include "pch.h"
+#include "CacheSizes.h"
+
+namespace
+{
+	CacheSizes Detect()
+	{
+		CacheSizes sizes;
+#ifdef _WIN32
+		DWORD bytes = 0;
+		GetLogicalProcessorInformation(nullptr, &bytes);
+		std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+		if (info.empty() || !GetLogicalProcessorInformation(info.data(), &bytes))
+		{
+			return sizes;
+		}
+
+		for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry : info)
+		{
+			if (entry.Relationship != RelationCache || entry.Cache.Type == CacheInstruction)
+			{
+				continue;
+			}
+
+			const size_t size = entry.Cache.Size;
+			switch (entry.Cache.Level)
+			{
+			case 1: sizes.l1 = size; break;
+			case 2: sizes.l2 = size; break;
+			case 3: sizes.l3 = size; break;
+			}
+		}
+#else
+		// sysfs has one directory per cache the first CPU can see, sizes like "48K"
+		for (int index = 0; index < 8; index++)
+		{
+			const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+			std::ifstream levelFile(dir + "level");
+			std::ifstream typeFile(dir + "type");
+			std::ifstream sizeFile(dir + "size");
+			int level = 0;
+			std::string type;
+			size_t size = 0;
+			char unit = 0;
+			if (!(levelFile >> level) || !(typeFile >> type) || !(sizeFile >> size) || type == "Instruction")
+			{
+				continue;
+			}
+
+			sizeFile >> unit;
+			size *= (unit == 'K') ? 1024 : (unit == 'M') ? 1024 * 1024 : 1;
+			switch (level)
+			{
+			case 1: sizes.l1 = size; break;
+			case 2: sizes.l2 = size; break;
+			case 3: sizes.l3 = size; break;
+			}
+		}
+#endif
+		return sizes;
+	}
+}
+
+const CacheSizes& CacheSizes::Get()
+{
+	static const CacheSizes s_sizes = Detect();
+	return s_sizes;
+}
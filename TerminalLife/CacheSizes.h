@@ -0,0 +1,13 @@
+﻿#pragma once
+
+// how big the data caches are, asked of the OS once. anything it won't say gets a size most desktop CPUs have
+struct CacheSizes
+{
+    // per core
+    size_t l1 = 32 * 1024;
+    size_t l2 = 1024 * 1024;
+    // shared, the last level
+    size_t l3 = 8 * 1024 * 1024;
+
+    static const CacheSizes& Get();
+};
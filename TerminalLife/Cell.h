@@ -1,31 +1,16 @@
 ﻿#pragma once
+
+// Board stores cells as separate state/age arrays, what's left here is how a cell gets shown
+// the states here are for showing, the rules use Rule states
 class Cell
 {
 public:
-    enum class State { Dead, Born, Live, Old, Dying };
+    enum class State : uint8_t { Dead, Born, Live, Old, Dying };
 
 private:
-    State _state;
-    int _age;
-    int _x;
-    int _y;
-    int _neighbors;
-    inline static int numDead = 0;
-    inline static int numLive = 0;
-    inline static int numBorn = 0;
-    inline static int numOld = 0;
-    inline static int numDying = 0;
     inline static int OldAge = -1;
 
 public:
-    Cell() : _state(State::Dead), _age(0), _x(0), _y(0), _neighbors(0)
-    {
-    }
-
-    Cell const& operator=(Cell& cell) = delete;
-
-    ~Cell() = default;
-
     static void SetOldAge(int age)
     {
         OldAge = age;
@@ -36,95 +21,27 @@ public:
         return OldAge;
     }
 
-    static int GetDeadCount()
-    {
-        return numDead;
-    }
-
-    static int GetLiveCount()
-    {
-        return numLive;
-    }
-
-    static int GetBornCount()
-    {
-        return numBorn;
-    }
-
-    static int GetOldCount()
-    {
-        return numOld;
-    }
-
-    static int GetDyingCount()
-    {
-        return numDying;
-    }
-
-    static bool ResetCounts()
-    {
-        numDead = 0;
-        numLive = 0;
-        numBorn = 0;
-        numDying = 0;
-        numOld = 0;
-        return true;
-    }
-
-    void SetXY(int x, int y)
-    {
-        _x = x;
-        _y = y;
-    }
-
-    int X() const
-    {
-        return _x;
-    }
-
-    int Y() const
-    {
-        return _y;
-    }
-
-    int Neighbors() const
-    {
-        return _neighbors;
-    }
-
-    void SetNeighbors(int n)
-    {
-        _neighbors = n;
-    }
-
-    void SetAge(int age)
-    {
-        _age = age;
-    }
-
-    int Age() const
-    {
-        return _age;
-    }
+    static const std::u8string& GetEmojiStateString(State state);
+};
 
-    void SetState(State state);
+// how many cells are in each state. every band of the board keeps its own
+// and Board adds them up after each pass, so there is nothing shared to fight over
+// live includes the old cells, born and dying are what happened in the last step
+struct CellCounts
+{
+    int dead = 0;
+    int live = 0;
+    int born = 0;
+    int old = 0;
+    int dying = 0;
 
-    State GetState() const
+    CellCounts& operator+=(const CellCounts& other)
     {
-        return _state;
+        dead += other.dead;
+        live += other.live;
+        born += other.born;
+        old += other.old;
+        dying += other.dying;
+        return *this;
     }
-
-    bool IsAlive() const;
-
-    bool IsAliveNotDying() const;
-
-    bool IsDead() const;
-
-    const char* GetStateString() const;
-
-    const std::u8string& GetEmojiStateString() const;
-
-    void NextGeneration();
-
-    void KillOldCell();
 };
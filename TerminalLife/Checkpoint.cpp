@@ -0,0 +1,292 @@
+﻿#include "pch.h"
+#include "Checkpoint.h"
+#include "Cell.h"
+
+namespace
+{
+	constexpr char Magic[8] = { 'T', 'L', 'I', 'F', 'E', 'C', 'K', 0 };
+
+	// a read only view of a whole file, unmapped when it goes away
+	class MappedFile
+	{
+	private:
+		const uint8_t* _data = nullptr;
+		size_t _size = 0;
+#ifdef _WIN32
+		HANDLE _file = INVALID_HANDLE_VALUE;
+		HANDLE _mapping = nullptr;
+#else
+		int _file = -1;
+#endif
+
+	public:
+		explicit MappedFile(const std::string& path)
+		{
+#ifdef _WIN32
+			_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			LARGE_INTEGER size{};
+			if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+			{
+				return;
+			}
+			_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (_mapping == nullptr)
+			{
+				return;
+			}
+			_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+			_size = _data ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+			_file = open(path.c_str(), O_RDONLY);
+			struct stat info {};
+			if (_file < 0 || fstat(_file, &info) != 0 || info.st_size == 0)
+			{
+				return;
+			}
+			void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+			if (data == MAP_FAILED)
+			{
+				return;
+			}
+			// it gets read front to back exactly once
+			madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+			_data = static_cast<const uint8_t*>(data);
+			_size = static_cast<size_t>(info.st_size);
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifdef _WIN32
+			if (_data)
+			{
+				UnmapViewOfFile(_data);
+			}
+			if (_mapping)
+			{
+				CloseHandle(_mapping);
+			}
+			if (_file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(_file);
+			}
+#else
+			if (_data)
+			{
+				munmap(const_cast<uint8_t*>(_data), _size);
+			}
+			if (_file >= 0)
+			{
+				close(_file);
+			}
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const uint8_t* Data() const
+		{
+			return _data;
+		}
+
+		size_t Size() const
+		{
+			return _size;
+		}
+	};
+
+	// the header makes sense and says the file is as long as it is
+	bool Valid(const Checkpoint::Header& header, uint64_t fileBytes)
+	{
+		return std::memcmp(header.magic, Magic, sizeof(Magic)) == 0
+			&& header.version == Checkpoint::Version
+			&& header.layout <= static_cast<uint32_t>(Board::Layout::Cells)
+			&& header.width > 0 && header.height > 0
+			&& header.rule[sizeof(header.rule) - 1] == 0
+			&& header.stateBytes == fileBytes - sizeof(Checkpoint::Header);
+	}
+}
+
+uint64_t Checkpoint::Checksum(const uint8_t* data, size_t bytes)
+{
+	uint64_t hash = 0x9e3779b97f4a7c15 ^ bytes;
+	size_t i = 0;
+	for (; i + 8 <= bytes; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		hash = std::rotl(hash ^ word, 31) * 0xbf58476d1ce4e5b9;
+	}
+
+	uint64_t tail = 0;
+	std::memcpy(&tail, data + i, bytes - i);
+	hash = std::rotl(hash ^ tail, 31) * 0xbf58476d1ce4e5b9;
+	return hash ^ (hash >> 29);
+}
+
+Checkpoint::Header Checkpoint::MakeHeader(const Board& board, std::string_view rule)
+{
+	Header header{};
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.layout = static_cast<uint32_t>(board.StorageLayout());
+	header.width = board.Width();
+	header.height = board.Height();
+	header.generation = board.Generation();
+	header.oldAge = Cell::GetOldAge();
+	rule.copy(header.rule, std::min(rule.size(), sizeof(header.rule) - 1));
+	return header;
+}
+
+bool Checkpoint::Write(const std::string& path, const Header& header, const std::vector<uint8_t>& state)
+{
+	Header written = header;
+	written.stateBytes = state.size();
+	written.checksum = Checksum(state.data(), state.size());
+
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&written), sizeof(written));
+		file.write(reinterpret_cast<const char*>(state.data()), static_cast<std::streamsize>(state.size()));
+		if (!file.flush())
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+bool Checkpoint::Save(const std::string& path, const Board& board, std::string_view rule)
+{
+	std::vector<uint8_t> state;
+	board.ExportState(state);
+	return Write(path, MakeHeader(board, rule), state);
+}
+
+std::optional<Checkpoint::Header> Checkpoint::ReadHeader(const std::string& path)
+{
+	std::error_code error;
+	const uint64_t bytes = std::filesystem::file_size(path, error);
+
+	Header header{};
+	std::ifstream file(path, std::ios::binary);
+	if (error || bytes < sizeof(Header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !Valid(header, bytes))
+	{
+		return std::nullopt;
+	}
+	return header;
+}
+
+std::optional<Checkpoint::Header> Checkpoint::Restore(const std::string& path, Board& board)
+{
+	const MappedFile file(path);
+	if (file.Size() < sizeof(Header))
+	{
+		return std::nullopt;
+	}
+
+	Header header;
+	std::memcpy(&header, file.Data(), sizeof(header));
+	const uint8_t* state = file.Data() + sizeof(Header);
+
+	// checked before anything is copied, so a bad file leaves the board as it was
+	if (!Valid(header, file.Size()) || header.width != board.Width() || header.height != board.Height()
+		|| Checksum(state, header.stateBytes) != header.checksum)
+	{
+		return std::nullopt;
+	}
+
+	if (!board.ImportState(static_cast<Board::Layout>(header.layout), state, header.stateBytes, header.generation))
+	{
+		return std::nullopt;
+	}
+	Cell::SetOldAge(header.oldAge);
+	return header;
+}
+
+Checkpointer::Checkpointer(std::string path, int64_t every, std::string rule, int64_t generation)
+	: _path(std::move(path)), _every(std::max<int64_t>(every, 1)), _rule(std::move(rule)), _next(((generation / _every) + 1) * _every), _taken(generation)
+{
+	_writer = std::thread(&Checkpointer::Run, this);
+}
+
+Checkpointer::~Checkpointer()
+{
+	{
+		std::lock_guard lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_one();
+	_writer.join();
+}
+
+void Checkpointer::Offer(const Board& board)
+{
+	if (board.Generation() < _next)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard lock(_mutex);
+		if (_busy)
+		{
+			// still writing the last one, try again next generation
+			return;
+		}
+
+		// the only part the simulation waits for
+		board.ExportState(_state);
+		_header = Checkpoint::MakeHeader(board, _rule);
+		_taken = board.Generation();
+		_busy = true;
+	}
+	// a HashLife step can go past a multiple, the next one is still a multiple
+	_next = ((board.Generation() / _every) + 1) * _every;
+	_wake.notify_one();
+}
+
+void Checkpointer::Finish(const Board& board)
+{
+	std::unique_lock lock(_mutex);
+	_idle.wait(lock, [this]() { return !_busy; });
+	if (board.Generation() == _taken)
+	{
+		return;
+	}
+
+	board.ExportState(_state);
+	_header = Checkpoint::MakeHeader(board, _rule);
+	_taken = board.Generation();
+	_busy = true;
+	_wake.notify_one();
+	_idle.wait(lock, [this]() { return !_busy; });
+}
+
+void Checkpointer::Run()
+{
+	std::unique_lock lock(_mutex);
+	while (true)
+	{
+		_wake.wait(lock, [this]() { return _busy || _quit; });
+		if (!_busy)
+		{
+			return;
+		}
+
+		// Offer won't touch the snapshot while _busy, so it's safe to write it unlocked
+		lock.unlock();
+		if (!Checkpoint::Write(_path, _header, _state))
+		{
+			std::cout << "TerminalLife: couldn't write checkpoint " << _path << std::endl;
+		}
+		lock.lock();
+		_busy = false;
+		_idle.notify_all();
+	}
+}
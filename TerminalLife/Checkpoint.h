@@ -0,0 +1,87 @@
+﻿#pragma once
+#include "Board.h"
+
+// binary snapshots of a whole board: a fixed header, then the board's ExportState bytes as they are in memory
+// restoring maps the file instead of reading it into a buffer first. it goes over the mapping twice, once for
+// the checksum and once to copy it into the board, so a damaged file gets turned away before the board is touched
+class Checkpoint
+{
+public:
+    static constexpr uint32_t Version = 1;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        // a Board::Layout
+        uint32_t layout;
+        int32_t width;
+        int32_t height;
+        int64_t generation;
+        int32_t oldAge;
+        int32_t reserved;
+        // the rulestring, zero padded
+        char rule[64];
+        uint64_t stateBytes;
+        // Checksum() of the state bytes
+        uint64_t checksum;
+    };
+    static_assert(sizeof(Header) == 120, "the header is written as it is in memory");
+
+    // cheap 64 bit checksum, a word at a time
+    static uint64_t Checksum(const uint8_t* data, size_t bytes);
+
+    // writes the board to path, false if that failed
+    static bool Save(const std::string& path, const Board& board, std::string_view rule);
+
+    // just the header, checked, so the board can be made the right size before Restore
+    static std::optional<Header> ReadHeader(const std::string& path);
+
+    // loads path into board, which has to be the size the header says, and sets Cell's OldAge
+    static std::optional<Header> Restore(const std::string& path, Board& board);
+
+    // writes the state to path through a temporary file, so a crash never leaves half a checkpoint
+    static bool Write(const std::string& path, const Header& header, const std::vector<uint8_t>& state);
+
+    static Header MakeHeader(const Board& board, std::string_view rule);
+};
+
+// takes a checkpoint at every multiple of so many generations without holding up the simulation
+// Offer copies the board while the simulation thread is between generations, and the file
+// gets written on a thread of its own. if the last one is still being written the offer is skipped
+// Finish takes one more as the run ends, so it can be picked up exactly where it stopped
+class Checkpointer
+{
+private:
+    std::string _path;
+    int64_t _every;
+    std::string _rule;
+    int64_t _next;
+    // the generation of the last snapshot taken
+    int64_t _taken;
+
+    Checkpoint::Header _header{};
+    std::vector<uint8_t> _state;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    bool _busy = false;
+    bool _quit = false;
+    std::thread _writer;
+
+    void Run();
+
+public:
+    // generation is where the board starts, the first checkpoint is at the next multiple of every after it
+    Checkpointer(std::string path, int64_t every, std::string rule, int64_t generation);
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // call from the thread that owns the board, after NextGeneration
+    void Offer(const Board& board);
+
+    // the board as the run ends, unless the last checkpoint already has it. returns once it's written
+    void Finish(const Board& board);
+};
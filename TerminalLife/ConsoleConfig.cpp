@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 #include "ConsoleConfig.h"
 
+#ifdef _WIN32
 ConsoleConfig::ConsoleConfig()
 {
 	// Set output mode to handle virtual terminal sequences
@@ -51,12 +52,16 @@ ConsoleConfig::ConsoleConfig()
 
 ConsoleConfig::~ConsoleConfig()
 {
+	// turn the cursor back on
+	std::cout << "\x1b[?25h" << std::flush;
 	SetConsoleMode(_hOut, _dwOriginalOutMode);
 }
 
 void ConsoleConfig::DrawBegin()
 {
 	GetConsoleScreenBufferInfo(_hOut, &_csbi);
+	_width = _csbi.dwSize.X;
+	_height = _csbi.dwSize.Y;
 
 	// turn off the cursor
 	std::cout << "\x1b[?25l" << std::endl;
@@ -65,4 +70,164 @@ void ConsoleConfig::DrawBegin()
 	std::cin.tie(nullptr);
 
 	Clear();
-}
\ No newline at end of file
+}
+
+ConsoleConfig::Key ConsoleConfig::ReadKey()
+{
+	// the low bit says the key went down since the last time anybody asked
+	static constexpr std::pair<int, Key> keys[] =
+	{
+		{ VK_ESCAPE, Key::Escape },
+		{ VK_SPACE, Key::Space },
+		{ VK_OEM_PLUS, Key::Plus },
+		{ VK_OEM_MINUS, Key::Minus },
+		{ VK_F1, Key::F1 },
+		{ 0x46, Key::F },
+		{ 0x53, Key::S },
+		{ 0x49, Key::I },
+		{ 0x50, Key::P },
+		{ VK_LEFT, Key::Left },
+		{ VK_RIGHT, Key::Right },
+		{ VK_UP, Key::Up },
+		{ VK_DOWN, Key::Down },
+		{ VK_OEM_PERIOD, Key::ZoomIn },
+		{ VK_OEM_COMMA, Key::ZoomOut },
+	};
+
+	for (const auto& [vk, key] : keys)
+	{
+		if (GetAsyncKeyState(vk) & 0x01)
+		{
+			return key;
+		}
+	}
+	return Key::None;
+}
+#else
+ConsoleConfig::ConsoleConfig()
+{
+	if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO))
+	{
+		std::cout << "TerminalLife: Needs to run in a terminal. 0x01" << std::endl;
+		exit(-1);
+	}
+
+	if (tcgetattr(STDIN_FILENO, &_originalMode) != 0)
+	{
+		std::cout << "TerminalLife: Error setting terminal preferences. 0x02" << std::endl;
+		exit(-1);
+	}
+
+	// don't sync the C++ streams to the C streams, for performance
+	// the emoji are already utf8 bytes, the terminal takes care of the rest
+	std::ios::sync_with_stdio(false);
+}
+
+ConsoleConfig::~ConsoleConfig()
+{
+	// turn the cursor back on
+	std::cout << "\x1b[?25h" << std::flush;
+	if (_raw)
+	{
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &_originalMode);
+	}
+}
+
+void ConsoleConfig::DrawBegin()
+{
+	winsize size = {};
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0)
+	{
+		_width = size.ws_col;
+		_height = size.ws_row;
+	}
+	else
+	{
+		_width = 80;
+		_height = 24;
+	}
+
+	// raw mode, keys show up one at a time without echo and reads never block
+	// Ctrl+C arrives as a key too, so the terminal always gets restored on the way out
+	termios raw = _originalMode;
+	raw.c_iflag &= ~(IXON | ICRNL);
+	raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+	raw.c_cc[VMIN] = 0;
+	raw.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0)
+	{
+		std::cout << "TerminalLife: Error setting terminal preferences. 0x03" << std::endl;
+		exit(-1);
+	}
+	_raw = true;
+
+	// turn off the cursor
+	std::cout << "\x1b[?25l" << std::endl;
+
+	//untie cin and cout, since we won't use cin anymore and this improves performance
+	std::cin.tie(nullptr);
+
+	Clear();
+}
+
+ConsoleConfig::Key ConsoleConfig::ReadKey()
+{
+	pollfd in = { STDIN_FILENO, POLLIN, 0 };
+	unsigned char c = 0;
+	if (poll(&in, 1, 0) <= 0 || read(STDIN_FILENO, &c, 1) != 1)
+	{
+		return Key::None;
+	}
+
+	switch (c)
+	{
+	case 0x03: return Key::Escape;
+	case ' ': return Key::Space;
+	case '+':
+	case '=': return Key::Plus;
+	case '-': return Key::Minus;
+	case 'f':
+	case 'F': return Key::F;
+	case 's':
+	case 'S': return Key::S;
+	case 'i':
+	case 'I': return Key::I;
+	case 'p':
+	case 'P': return Key::P;
+	case '.':
+	case '>': return Key::ZoomIn;
+	case ',':
+	case '<': return Key::ZoomOut;
+	case 0x1b: break;
+	default: return Key::None;
+	}
+
+	// a lone ESC is the key, anything right behind it is an escape sequence from some other key
+	// F1 is ESC O P, or ESC [ 1 1 ~ on some terminals, the arrows ESC [ A to D or ESC O A to D
+	char sequence[8] = {};
+	if (poll(&in, 1, 10) <= 0)
+	{
+		return Key::Escape;
+	}
+
+	const ssize_t n = read(STDIN_FILENO, sequence, sizeof(sequence));
+	const std::string_view rest(sequence, n > 0 ? static_cast<size_t>(n) : 0);
+	if (rest == "OP" || rest == "[11~")
+	{
+		return Key::F1;
+	}
+
+	if (rest.size() == 2 && (rest[0] == '[' || rest[0] == 'O'))
+	{
+		switch (rest[1])
+		{
+		case 'A': return Key::Up;
+		case 'B': return Key::Down;
+		case 'C': return Key::Right;
+		case 'D': return Key::Left;
+		default: break;
+		}
+	}
+	return Key::None;
+}
+#endif
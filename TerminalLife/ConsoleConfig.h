@@ -3,47 +3,61 @@
 
 class ConsoleConfig
 {
+public:
+    // the keys TerminalLife listens to
+    enum class Key { None, Escape, Space, Plus, Minus, F1, F, S, I, P, Left, Right, Up, Down, ZoomIn, ZoomOut };
+
 private:
+#ifdef _WIN32
     DWORD _dwOriginalOutMode = 0;
     HANDLE _hOut = nullptr;
     CONSOLE_SCREEN_BUFFER_INFO _csbi = {};
+#else
+    termios _originalMode = {};
+    bool _raw = false;
+#endif
+    int _width = 0;
+    int _height = 0;
 
 public:
     ConsoleConfig();
     ~ConsoleConfig();
 
+    // plain VT on every platform, no need to start a shell for it
     void Clear() const
     {
-        system("CLS");
+        std::cout << "\x1b[2J\x1b[H" << std::flush;
     }
 
     int Width() const
     {
-        return _csbi.dwSize.X;
+        return _width;
     }
 
     int Height() const
     {
-        return _csbi.dwSize.Y;
+        return _height;
     }
 
     void DrawBegin();
 
     void SetPositionHome()
     {
-        static COORD coordScreen = { 0, 0 };
-        SetConsoleCursorPosition(_hOut, coordScreen);
+        SetPosition(0, 0);
     }
 
     void SetPositionBoard()
     {
-        static COORD coordScreen = { 0, 5 };
-        SetConsoleCursorPosition(_hOut, coordScreen);
+        SetPosition(0, 5);
     }
 
+    // goes through the same stream as everything else, so it can't get ahead of what's been printed
     void SetPosition(short x, short y)
     {
-        static COORD coordScreen = { x, y };
-        SetConsoleCursorPosition(_hOut, coordScreen);
+        std::cout << "\x1b[" << (y + 1) << ';' << (x + 1) << 'H';
     }
+
+    // the next key pressed since the last call, Key::None when there are no more
+    // never waits, on Windows every key only shows up once no matter how often it was pressed
+    static Key ReadKey();
 };
@@ -0,0 +1,48 @@
+﻿#include "pch.h"
+#include "CycleDetector.h"
+
+void CycleDetector::Record(int64_t generation, uint64_t hash, bool empty)
+{
+	if (empty && !_extinct)
+	{
+		_extinctSince = generation;
+	}
+	_extinct = empty;
+
+	// the first repeat found is the one that counts, a cycle doesn't stop being one
+	const auto seen = _seen.find(hash);
+	if (seen != _seen.end())
+	{
+		if (_period == 0 && generation > seen->second)
+		{
+			_period = generation - seen->second;
+			_start = seen->second;
+		}
+		seen->second = generation;
+		return;
+	}
+
+	_seen.emplace(hash, generation);
+	_order.push_back(hash);
+	if (_order.size() > History)
+	{
+		_seen.erase(_order.front());
+		_order.pop_front();
+	}
+}
+
+void CycleDetector::Reset()
+{
+	_extinct = false;
+	_extinctSince = 0;
+
+	// clearing an empty map still goes over all its buckets, and SetCell calls this a lot
+	if (_order.empty() && _period == 0)
+	{
+		return;
+	}
+	_seen.clear();
+	_order.clear();
+	_period = 0;
+	_start = 0;
+}
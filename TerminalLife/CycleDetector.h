@@ -0,0 +1,50 @@
+﻿#pragma once
+
+// watches the board's hash go by one generation at a time and notices when one comes back
+// a hash seen again p generations later means the board is in a cycle of period p (1 is frozen)
+// only the last History generations are remembered, so longer periods go unnoticed
+class CycleDetector
+{
+public:
+    static constexpr int History = 4096;
+
+private:
+    std::unordered_map<uint64_t, int64_t> _seen;
+    // the hashes in _seen, oldest first, so the oldest can be forgotten
+    std::deque<uint64_t> _order;
+    int64_t _period = 0;
+    int64_t _start = 0;
+    bool _extinct = false;
+    int64_t _extinctSince = 0;
+
+public:
+    // hash is the board's hash at generation, empty says nothing is alive
+    void Record(int64_t generation, uint64_t hash, bool empty);
+
+    // forget everything, the board was changed by hand
+    void Reset();
+
+    // 0 until a cycle turns up
+    int64_t Period() const
+    {
+        return _period;
+    }
+
+    // the first generation of the cycle
+    int64_t Start() const
+    {
+        return _start;
+    }
+
+    // nothing left alive, which is also a cycle of period 1
+    bool Extinct() const
+    {
+        return _extinct;
+    }
+
+    // the generation the board went empty, while Extinct()
+    int64_t ExtinctSince() const
+    {
+        return _extinctSince;
+    }
+};
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include "Cell.h"
+#include "Statistics.h"
+
+// the part of the board that's on the screen and how far it's zoomed out
+// zoom 0 draws every cell as an emoji, zoom z > 0 draws braille where each of the 2x4 dots
+// in a character stands for a 2^(z-1) square of cells and is lit if any of them is alive
+struct Viewport
+{
+    // the board cell in the top left corner
+    int x = 0;
+    int y = 0;
+    int zoom = 0;
+    // the terminal columns and rows there are for the board
+    int columns = 0;
+    int rows = 0;
+
+    int Block() const
+    {
+        return (zoom > 0) ? 1 << (zoom - 1) : 1;
+    }
+
+    // board cells across and down one character
+    int GlyphWidth() const
+    {
+        return (zoom > 0) ? 2 * Block() : 1;
+    }
+
+    int GlyphHeight() const
+    {
+        return (zoom > 0) ? 4 * Block() : 1;
+    }
+
+    // characters that fit on the screen, emoji are two columns wide
+    int GlyphColumns() const
+    {
+        return (zoom > 0) ? columns : columns / 2;
+    }
+
+    int GlyphRows() const
+    {
+        return rows;
+    }
+};
+
+// one generation as the render thread sees it, copied out of the Board by the simulation thread
+// so the board can move on while this gets drawn. only what fits on the screen gets copied
+struct Frame
+{
+    // characters across and down, only as many as the board fills
+    int width = 0;
+    int height = 0;
+    // Viewport::zoom, 0 for emoji
+    int zoom = 0;
+    // the generation, its counts and where its live cells are
+    Sample sample;
+    // population of the last TrendLength generations, oldest first
+    static constexpr size_t TrendLength = 24;
+    std::vector<int> trend;
+    double activeRatio = 1.0;
+    // CycleDetector::Period, 0 while the board is still going somewhere
+    int64_t period = 0;
+    // row by row, a Cell::State per character at zoom 0, the braille dot bits otherwise
+    std::vector<uint8_t> glyphs;
+};
@@ -0,0 +1,87 @@
+﻿#include "pch.h"
+#include "FrameWriter.h"
+
+FrameWriter::FrameWriter()
+{
+#ifdef _WIN32
+	_hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+#endif
+}
+
+void FrameWriter::Grow(size_t needed)
+{
+	const size_t capacity = std::max(needed, _capacity * 2);
+	std::unique_ptr<char[]> arena = std::make_unique_for_overwrite<char[]>(capacity);
+	if (_size > 0)
+	{
+		std::memcpy(arena.get(), _arena.get(), _size);
+	}
+
+	_arena = std::move(arena);
+	_capacity = capacity;
+	_allocations++;
+}
+
+void FrameWriter::Begin(int width, int height)
+{
+	_size = 0;
+	_allocations = 0;
+
+	const size_t needed = FixedBytes + (static_cast<size_t>(height) * (RowBytes + (static_cast<size_t>(width) * CellBytes)));
+	if (needed > _capacity)
+	{
+		Grow(needed);
+	}
+}
+
+void FrameWriter::AppendNumber(int64_t value)
+{
+	char number[24];
+	Append(std::string_view(number, std::to_chars(number, number + sizeof(number), value).ptr));
+}
+
+void FrameWriter::MoveTo(int x, int y)
+{
+	Append("\x1b[");
+	AppendNumber(y + 1);
+	Append(";");
+	AppendNumber(x + 1);
+	Append("H");
+}
+
+void FrameWriter::Flush()
+{
+	// the write only comes back short if something interrupted it, then the rest goes in another
+	const char* data = _arena.get();
+	size_t left = _size;
+	int writes = 0;
+	while (left > 0)
+	{
+#ifdef _WIN32
+		DWORD written = 0;
+		if (!WriteFile(_hOut, data, static_cast<DWORD>(left), &written, nullptr))
+		{
+			break;
+		}
+#else
+		const ssize_t written = write(STDOUT_FILENO, data, left);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+#endif
+		data += written;
+		left -= static_cast<size_t>(written);
+		writes++;
+	}
+
+	_lastBytes = _size;
+	_lastAllocations = _allocations;
+	_lastWrites = writes;
+	_size = 0;
+	_allocations = 0;
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+// everything that goes on the screen in one frame, HUD, cursor moves and board, gets put together here
+// and goes out in a single write. the arena is sized from the board once, so putting a frame
+// together never allocates, and the terminal never sees half a frame
+class FrameWriter
+{
+private:
+    // room for the HUD, then the worst case per row and per cell of anything the renderer draws
+    static constexpr size_t FixedBytes = 4096;
+    static constexpr size_t RowBytes = 16;
+    static constexpr size_t CellBytes = 8;
+
+    std::unique_ptr<char[]> _arena;
+    size_t _capacity = 0;
+    size_t _size = 0;
+#ifdef _WIN32
+    HANDLE _hOut = nullptr;
+#endif
+
+    // this frame so far, and the last one that went out
+    int _allocations = 0;
+    int _lastAllocations = 0;
+    int _lastWrites = 0;
+    size_t _lastBytes = 0;
+
+    // only if the estimate was wrong, gets counted as an allocation
+    void Grow(size_t needed);
+
+public:
+    FrameWriter();
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter const& operator=(const FrameWriter&) = delete;
+
+    // starts a frame for a board this big, allocates only when the board got bigger
+    void Begin(int width, int height);
+
+    void Append(std::string_view text)
+    {
+        if (_size + text.size() > _capacity)
+        {
+            Grow(_size + text.size());
+        }
+        std::memcpy(_arena.get() + _size, text.data(), text.size());
+        _size += text.size();
+    }
+
+    void Append(const std::u8string& text)
+    {
+        Append(std::string_view(reinterpret_cast<const char*>(text.data()), text.size()));
+    }
+
+    void AppendNumber(int64_t value);
+
+    // VT cursor move to column x, row y, both counting from 0
+    void MoveTo(int x, int y);
+
+    size_t Size() const
+    {
+        return _size;
+    }
+
+    // writes the frame out, normally with a single system call
+    void Flush();
+
+    size_t LastBytes() const
+    {
+        return _lastBytes;
+    }
+
+    int LastAllocations() const
+    {
+        return _lastAllocations;
+    }
+
+    int LastWrites() const
+    {
+        return _lastWrites;
+    }
+};
@@ -0,0 +1,722 @@
+﻿#include "pch.h"
+#include "HashLife.h"
+#include "SplitMix.h"
+
+namespace
+{
+	// a live cell at (x, y) counts East^x * South^y towards a hash, so moving a square by (dx, dy) multiplies
+	// its hash by East^dx * South^dy and a node's hash follows from its children's. both odd so they have inverses
+	constexpr uint64_t East = 0x9e3779b97f4a7c15;
+	constexpr uint64_t South = 0xc2b2ae3d27d4eb4f;
+
+	// Newton's method, every round doubles the bits that are right, and odd * odd is already 1 in the low three
+	constexpr uint64_t Inverse(uint64_t odd)
+	{
+		uint64_t inverse = odd;
+		for (int round = 0; round < 5; round++)
+		{
+			inverse *= 2 - (odd * inverse);
+		}
+		return inverse;
+	}
+
+	constexpr uint64_t Power(uint64_t base, int64_t exponent)
+	{
+		uint64_t e = (exponent < 0) ? (~static_cast<uint64_t>(exponent) + 1) : static_cast<uint64_t>(exponent);
+		base = (exponent < 0) ? Inverse(base) : base;
+		uint64_t result = 1;
+		for (; e > 0; e >>= 1, base *= base)
+		{
+			result = (e & 1) ? result * base : result;
+		}
+		return result;
+	}
+
+	// base^(2^level), what a child that far along multiplies by
+	constexpr std::array<uint64_t, 64> Strides(uint64_t base)
+	{
+		std::array<uint64_t, 64> strides{};
+		for (size_t level = 0; level < strides.size(); level++, base *= base)
+		{
+			strides[level] = base;
+		}
+		return strides;
+	}
+
+	constexpr std::array<uint64_t, 64> EastStrides = Strides(East);
+	constexpr std::array<uint64_t, 64> SouthStrides = Strides(South);
+	static_assert(Power(East, -3) * Power(East, 3) == 1);
+}
+
+HashLife::HashLife()
+{
+	Node dead;
+	Node alive;
+	alive.population = 1;
+	alive.hash = 1;
+	_nodes.push_back(dead);
+	_nodes.push_back(alive);
+
+	_table.resize(size_t{ 1 } << 16, Invalid);
+	_empty.push_back(Dead);
+
+	_root = Empty(3);
+	_originX = -4;
+	_originY = -4;
+	_previous = _root;
+	_previousX = _originX;
+	_previousY = _originY;
+}
+
+size_t HashLife::Hash(NodeId nw, NodeId ne, NodeId sw, NodeId se)
+{
+	uint64_t h = nw;
+	h = (h * 0x9e3779b97f4a7c15ull) + ne;
+	h = (h * 0x9e3779b97f4a7c15ull) + sw;
+	h = (h * 0x9e3779b97f4a7c15ull) + se;
+	h ^= h >> 31;
+	h *= 0xbf58476d1ce4e5b9ull;
+	h ^= h >> 29;
+	return static_cast<size_t>(h);
+}
+
+HashLife::NodeId HashLife::NewNode(const Node& node)
+{
+	if (!_free.empty())
+	{
+		const NodeId id = _free.back();
+		_free.pop_back();
+		_nodes[id] = node;
+		return id;
+	}
+
+	_nodes.push_back(node);
+	return static_cast<NodeId>(_nodes.size() - 1);
+}
+
+void HashLife::Insert(NodeId id)
+{
+	const Node& node = _nodes[id];
+	const size_t mask = _table.size() - 1;
+	size_t slot = Hash(node.nw, node.ne, node.sw, node.se) & mask;
+	while (_table[slot] != Invalid)
+	{
+		slot = (slot + 1) & mask;
+	}
+	_table[slot] = id;
+	_tableCount++;
+}
+
+void HashLife::Grow()
+{
+	_table.assign(_table.size() * 2, Invalid);
+	_tableCount = 0;
+	for (NodeId id = Alive + 1; id < _nodes.size(); id++)
+	{
+		if (!_nodes[id].free)
+		{
+			Insert(id);
+		}
+	}
+}
+
+HashLife::NodeId HashLife::Join(NodeId nw, NodeId ne, NodeId sw, NodeId se)
+{
+	// keep the table under half full so the probes stay short
+	if (_tableCount * 2 >= _table.size())
+	{
+		Grow();
+	}
+
+	const size_t mask = _table.size() - 1;
+	size_t slot = Hash(nw, ne, sw, se) & mask;
+	while (_table[slot] != Invalid)
+	{
+		const Node& node = _nodes[_table[slot]];
+		if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se)
+		{
+			return _table[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	Node node;
+	node.nw = nw;
+	node.ne = ne;
+	node.sw = sw;
+	node.se = se;
+	node.level = static_cast<uint8_t>(_nodes[nw].level + 1);
+	node.population = _nodes[nw].population + _nodes[ne].population + _nodes[sw].population + _nodes[se].population;
+	const int half = _nodes[nw].level;
+	node.hash = _nodes[nw].hash + (EastStrides[half] * _nodes[ne].hash) + (SouthStrides[half] * _nodes[sw].hash)
+		+ (EastStrides[half] * SouthStrides[half] * _nodes[se].hash);
+
+	const NodeId id = NewNode(node);
+	_table[slot] = id;
+	_tableCount++;
+	return id;
+}
+
+HashLife::NodeId HashLife::Empty(int level)
+{
+	while (static_cast<int>(_empty.size()) <= level)
+	{
+		const NodeId e = _empty.back();
+		_empty.push_back(Join(e, e, e, e));
+	}
+	return _empty[level];
+}
+
+HashLife::NodeId HashLife::Centre(NodeId id)
+{
+	const Node n = _nodes[id];
+	return Join(_nodes[n.nw].se, _nodes[n.ne].sw, _nodes[n.sw].ne, _nodes[n.se].nw);
+}
+
+HashLife::NodeId HashLife::Expand(NodeId id)
+{
+	// one level up with the old node in the middle and dead space all around it
+	const Node n = _nodes[id];
+	const NodeId e = Empty(n.level - 1);
+	return Join(Join(e, e, e, n.nw), Join(e, e, n.ne, e), Join(e, n.sw, e, e), Join(n.se, e, e, e));
+}
+
+bool HashLife::FitsInCentre(NodeId id) const
+{
+	const Node& n = _nodes[id];
+	const uint64_t centre = _nodes[_nodes[n.nw].se].population + _nodes[_nodes[n.ne].sw].population +
+		_nodes[_nodes[n.sw].ne].population + _nodes[_nodes[n.se].nw].population;
+	return centre == n.population;
+}
+
+HashLife::NodeId HashLife::Life4x4(NodeId id)
+{
+	// lay the 16 cells out as bits, bit (x + 4y)
+	const Node n = _nodes[id];
+	uint32_t grid = 0;
+	const NodeId quads[4] = { n.nw, n.ne, n.sw, n.se };
+	for (int q = 0; q < 4; q++)
+	{
+		const Node& quad = _nodes[quads[q]];
+		const int qx = (q & 1) * 2;
+		const int qy = (q >> 1) * 2;
+		grid |= static_cast<uint32_t>(quad.nw == Alive) << (qx + (4 * qy));
+		grid |= static_cast<uint32_t>(quad.ne == Alive) << (qx + 1 + (4 * qy));
+		grid |= static_cast<uint32_t>(quad.sw == Alive) << (qx + (4 * (qy + 1)));
+		grid |= static_cast<uint32_t>(quad.se == Alive) << (qx + 1 + (4 * (qy + 1)));
+	}
+
+	NodeId next[4];
+	for (int c = 0; c < 4; c++)
+	{
+		const int x = 1 + (c & 1);
+		const int y = 1 + (c >> 1);
+
+		int count = 0;
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				if (dx != 0 || dy != 0)
+				{
+					count += (grid >> ((x + dx) + (4 * (y + dy)))) & 1;
+				}
+			}
+		}
+
+		const bool alive = (grid >> (x + (4 * y))) & 1;
+		const uint16_t rule = alive ? _rule.survive : _rule.birth;
+		next[c] = ((rule >> count) & 1) ? Alive : Dead;
+	}
+
+	return Join(next[0], next[1], next[2], next[3]);
+}
+
+HashLife::NodeId HashLife::Successor(NodeId id, int step)
+{
+	// copies, Join can move _nodes around
+	const Node m = _nodes[id];
+	if (m.population == 0)
+	{
+		return Empty(m.level - 1);
+	}
+
+	// a level n node can move at most 2^(n-2) generations, its children half that
+	step = std::min(step, m.level - 2);
+	if (m.result != Invalid && m.resultStep == step)
+	{
+		return m.result;
+	}
+
+	NodeId result;
+	if (m.level == 2)
+	{
+		result = Life4x4(id);
+	}
+	else
+	{
+		const Node a = _nodes[m.nw];
+		const Node b = _nodes[m.ne];
+		const Node c = _nodes[m.sw];
+		const Node d = _nodes[m.se];
+
+		// nine overlapping level-1 squares covering the middle of m, each stepped forward
+		const NodeId c1 = Successor(m.nw, step);
+		const NodeId c2 = Successor(Join(a.ne, b.nw, a.se, b.sw), step);
+		const NodeId c3 = Successor(m.ne, step);
+		const NodeId c4 = Successor(Join(a.sw, a.se, c.nw, c.ne), step);
+		const NodeId c5 = Successor(Join(a.se, b.sw, c.ne, d.nw), step);
+		const NodeId c6 = Successor(Join(b.sw, b.se, d.nw, d.ne), step);
+		const NodeId c7 = Successor(m.sw, step);
+		const NodeId c8 = Successor(Join(c.ne, d.nw, c.se, d.sw), step);
+		const NodeId c9 = Successor(m.se, step);
+
+		if (step < m.level - 2)
+		{
+			// the nine are already far enough along, just stitch their centres together
+			const auto quad = [this](NodeId q1, NodeId q2, NodeId q3, NodeId q4)
+			{
+				return Join(_nodes[q1].se, _nodes[q2].sw, _nodes[q3].ne, _nodes[q4].nw);
+			};
+			const NodeId nw = quad(c1, c2, c4, c5);
+			const NodeId ne = quad(c2, c3, c5, c6);
+			const NodeId sw = quad(c4, c5, c7, c8);
+			const NodeId se = quad(c5, c6, c8, c9);
+			result = Join(nw, ne, sw, se);
+		}
+		else
+		{
+			// full speed, step the four corners of the nine a second time
+			const NodeId nw = Successor(Join(c1, c2, c4, c5), step);
+			const NodeId ne = Successor(Join(c2, c3, c5, c6), step);
+			const NodeId sw = Successor(Join(c4, c5, c7, c8), step);
+			const NodeId se = Successor(Join(c5, c6, c8, c9), step);
+			result = Join(nw, ne, sw, se);
+		}
+	}
+
+	Node& node = _nodes[id];
+	node.result = result;
+	node.resultStep = static_cast<uint8_t>(step);
+	return result;
+}
+
+HashLife::NodeId HashLife::SetNode(NodeId id, int64_t x, int64_t y, bool alive)
+{
+	const Node n = _nodes[id];
+	if (n.level == 0)
+	{
+		return alive ? Alive : Dead;
+	}
+
+	const int64_t half = int64_t{ 1 } << (n.level - 1);
+	if (y < half)
+	{
+		if (x < half)
+		{
+			return Join(SetNode(n.nw, x, y, alive), n.ne, n.sw, n.se);
+		}
+		return Join(n.nw, SetNode(n.ne, x - half, y, alive), n.sw, n.se);
+	}
+
+	if (x < half)
+	{
+		return Join(n.nw, n.ne, SetNode(n.sw, x, y - half, alive), n.se);
+	}
+	return Join(n.nw, n.ne, n.sw, SetNode(n.se, x - half, y - half, alive));
+}
+
+void HashLife::SetRule(const PackedRule& rule)
+{
+	_rule = rule;
+	for (Node& node : _nodes)
+	{
+		node.result = Invalid;
+	}
+}
+
+void HashLife::Clear()
+{
+	const PackedRule rule = _rule;
+	const size_t maxNodes = _maxNodes;
+	*this = HashLife();
+	_rule = rule;
+	_maxNodes = maxNodes;
+}
+
+void HashLife::Set(int64_t x, int64_t y, bool alive)
+{
+	// grow the root until it covers (x, y)
+	while (x < _originX || y < _originY || x >= _originX + (int64_t{ 1 } << Level()) || y >= _originY + (int64_t{ 1 } << Level()))
+	{
+		const int64_t half = int64_t{ 1 } << (Level() - 1);
+		_root = Expand(_root);
+		_originX -= half;
+		_originY -= half;
+	}
+
+	_root = SetNode(_root, x - _originX, y - _originY, alive);
+}
+
+bool HashLife::GetNode(NodeId id, int64_t nodeX, int64_t nodeY, int64_t x, int64_t y) const
+{
+	x -= nodeX;
+	y -= nodeY;
+	const int64_t size = int64_t{ 1 } << _nodes[id].level;
+	if (x < 0 || y < 0 || x >= size || y >= size)
+	{
+		return false;
+	}
+
+	while (_nodes[id].level > 0)
+	{
+		const Node& n = _nodes[id];
+		if (n.population == 0)
+		{
+			return false;
+		}
+
+		const int64_t half = int64_t{ 1 } << (n.level - 1);
+		const bool east = x >= half;
+		const bool south = y >= half;
+		id = south ? (east ? n.se : n.sw) : (east ? n.ne : n.nw);
+		x -= east ? half : 0;
+		y -= south ? half : 0;
+	}
+	return id == Alive;
+}
+
+bool HashLife::Get(int64_t x, int64_t y) const
+{
+	return GetNode(_root, _originX, _originY, x, y);
+}
+
+bool HashLife::GetPrevious(int64_t x, int64_t y) const
+{
+	return GetNode(_previous, _previousX, _previousY, x, y);
+}
+
+void HashLife::Step(int log2)
+{
+	log2 = std::clamp(log2, 0, MaxLevel - 3);
+
+	// only between steps, nothing below here holds on to NodeIds
+	if (NodeCount() > _maxNodes)
+	{
+		CollectGarbage();
+	}
+	_previous = _root;
+	_previousX = _originX;
+	_previousY = _originY;
+
+	// the result of a node is its centre half, so first make sure there's enough dead space
+	// around the pattern for it to grow into: everything in the centre half, then one more level
+	while (Level() < log2 + 2 || !FitsInCentre(_root))
+	{
+		const int64_t half = int64_t{ 1 } << (Level() - 1);
+		_root = Expand(_root);
+		_originX -= half;
+		_originY -= half;
+	}
+
+	const int64_t half = int64_t{ 1 } << (Level() - 1);
+	_root = Expand(_root);
+	_originX -= half;
+	_originY -= half;
+
+	const int64_t quarter = int64_t{ 1 } << (Level() - 2);
+	_root = Successor(_root, log2);
+	_originX += quarter;
+	_originY += quarter;
+	_generation += uint64_t{ 1 } << log2;
+
+	// and trim the dead space back off so the root doesn't keep growing
+	while (Level() > 3 && FitsInCentre(_root))
+	{
+		const int64_t shift = int64_t{ 1 } << (Level() - 2);
+		_root = Centre(_root);
+		_originX += shift;
+		_originY += shift;
+	}
+}
+
+void HashLife::Advance(uint64_t generations)
+{
+	for (int log2 = 0; generations > 0; log2++, generations >>= 1)
+	{
+		if (generations & 1)
+		{
+			Step(log2);
+		}
+	}
+}
+
+HashLife::Window HashLife::Clip(const Window& window, int64_t x, int64_t y, int64_t size)
+{
+	return Window{ std::max(window.x0, x), std::max(window.y0, y), std::min(window.x1, x + size), std::min(window.y1, y + size) };
+}
+
+HashLife::NodeId HashLife::NodeAt(int level, int64_t x, int64_t y) const
+{
+	// Invalid if it's outside the root, which is all dead
+	const int64_t size = int64_t{ 1 } << Level();
+	x -= _originX;
+	y -= _originY;
+	if (x < 0 || y < 0 || x >= size || y >= size)
+	{
+		return Invalid;
+	}
+
+	NodeId id = _root;
+	while (_nodes[id].level > level && _nodes[id].population > 0)
+	{
+		const Node& n = _nodes[id];
+		const int64_t half = int64_t{ 1 } << (n.level - 1);
+		const bool east = x >= half;
+		const bool south = y >= half;
+		id = south ? (east ? n.se : n.sw) : (east ? n.ne : n.nw);
+		x -= east ? half : 0;
+		y -= south ? half : 0;
+	}
+	return id;
+}
+
+uint64_t HashLife::CountNode(NodeId id, int64_t nodeX, int64_t nodeY, const Window& window) const
+{
+	const Node& n = _nodes[id];
+	const int64_t size = int64_t{ 1 } << n.level;
+	if (n.population == 0 || nodeX >= window.x1 || nodeY >= window.y1 || nodeX + size <= window.x0 || nodeY + size <= window.y0)
+	{
+		return 0;
+	}
+	if (nodeX >= window.x0 && nodeY >= window.y0 && nodeX + size <= window.x1 && nodeY + size <= window.y1)
+	{
+		return n.population;
+	}
+
+	const int64_t half = size / 2;
+	return CountNode(n.nw, nodeX, nodeY, window) + CountNode(n.ne, nodeX + half, nodeY, window) +
+		CountNode(n.sw, nodeX, nodeY + half, window) + CountNode(n.se, nodeX + half, nodeY + half, window);
+}
+
+uint64_t HashLife::Population(int64_t x, int64_t y, int64_t width, int64_t height) const
+{
+	return CountNode(_root, _originX, _originY, Window{ x, y, x + width, y + height });
+}
+
+void HashLife::ChangesAligned(NodeId before, NodeId after, int64_t nodeX, int64_t nodeY, const Window& window, uint64_t& born, uint64_t& dying) const
+{
+	const int64_t size = int64_t{ 1 } << _nodes[before].level;
+	if (before == after || nodeX >= window.x1 || nodeY >= window.y1 || nodeX + size <= window.x0 || nodeY + size <= window.y0)
+	{
+		return;
+	}
+
+	// one side empty, so everything on the other one changed. otherwise they both have something, they're
+	// different nodes so they can't be single cells, and the children line up too
+	if (_nodes[before].population == 0 || _nodes[after].population == 0)
+	{
+		born += CountNode(after, nodeX, nodeY, window);
+		dying += CountNode(before, nodeX, nodeY, window);
+		return;
+	}
+
+	const Node& b = _nodes[before];
+	const Node& a = _nodes[after];
+	const int64_t half = size / 2;
+	ChangesAligned(b.nw, a.nw, nodeX, nodeY, window, born, dying);
+	ChangesAligned(b.ne, a.ne, nodeX + half, nodeY, window, born, dying);
+	ChangesAligned(b.sw, a.sw, nodeX, nodeY + half, window, born, dying);
+	ChangesAligned(b.se, a.se, nodeX + half, nodeY + half, window, born, dying);
+}
+
+void HashLife::ChangesNode(NodeId before, int64_t nodeX, int64_t nodeY, int aligned, const Window& window, uint64_t& born, uint64_t& dying) const
+{
+	const Node& n = _nodes[before];
+	const int64_t size = int64_t{ 1 } << n.level;
+	if (nodeX >= window.x1 || nodeY >= window.y1 || nodeX + size <= window.x0 || nodeY + size <= window.y0)
+	{
+		return;
+	}
+
+	// nothing here before, so whatever is here now was born
+	if (n.population == 0)
+	{
+		born += CountNode(_root, _originX, _originY, Clip(window, nodeX, nodeY, size));
+		return;
+	}
+
+	// small enough to be a whole node of the new tree as well
+	if (n.level <= aligned)
+	{
+		const NodeId after = NodeAt(n.level, nodeX, nodeY);
+		if (after == Invalid)
+		{
+			dying += CountNode(before, nodeX, nodeY, window);
+			return;
+		}
+		ChangesAligned(before, after, nodeX, nodeY, window, born, dying);
+		return;
+	}
+
+	const int64_t half = size / 2;
+	ChangesNode(n.nw, nodeX, nodeY, aligned, window, born, dying);
+	ChangesNode(n.ne, nodeX + half, nodeY, aligned, window, born, dying);
+	ChangesNode(n.sw, nodeX, nodeY + half, aligned, window, born, dying);
+	ChangesNode(n.se, nodeX + half, nodeY + half, aligned, window, born, dying);
+}
+
+void HashLife::Changes(int64_t x, int64_t y, int64_t width, int64_t height, uint64_t& born, uint64_t& dying) const
+{
+	born = 0;
+	dying = 0;
+	const Window window{ x, y, x + width, y + height };
+
+	// the two roots put their squares on grids that line up up to some size, below that a node of
+	// the old tree covers exactly the same cells as a node of the new one, and the same node means the same cells
+	const int aligned = std::min({ std::countr_zero(static_cast<uint64_t>(_previousX - _originX)), std::countr_zero(static_cast<uint64_t>(_previousY - _originY)),
+		static_cast<int>(_nodes[_previous].level), Level() });
+	ChangesNode(_previous, _previousX, _previousY, aligned, window, born, dying);
+
+	// and anything alive now outside the old root was born
+	const int64_t size = int64_t{ 1 } << _nodes[_previous].level;
+	born += CountNode(_root, _originX, _originY, window) - CountNode(_root, _originX, _originY, Clip(window, _previousX, _previousY, size));
+}
+
+void HashLife::BoundsNode(NodeId id, int64_t nodeX, int64_t nodeY, const Window& window, Window& found) const
+{
+	const Node& n = _nodes[id];
+	const int64_t size = int64_t{ 1 } << n.level;
+	if (n.population == 0 || nodeX >= window.x1 || nodeY >= window.y1 || nodeX + size <= window.x0 || nodeY + size <= window.y0)
+	{
+		return;
+	}
+
+	// nothing in here could make what's been found any bigger
+	const bool any = found.x0 < found.x1;
+	if (any && nodeX >= found.x0 && nodeY >= found.y0 && nodeX + size <= found.x1 && nodeY + size <= found.y1)
+	{
+		return;
+	}
+
+	if (n.level == 0)
+	{
+		found = any ? Window{ std::min(found.x0, nodeX), std::min(found.y0, nodeY), std::max(found.x1, nodeX + 1), std::max(found.y1, nodeY + 1) }
+			: Window{ nodeX, nodeY, nodeX + 1, nodeY + 1 };
+		return;
+	}
+
+	const int64_t half = size / 2;
+	BoundsNode(n.nw, nodeX, nodeY, window, found);
+	BoundsNode(n.ne, nodeX + half, nodeY, window, found);
+	BoundsNode(n.sw, nodeX, nodeY + half, window, found);
+	BoundsNode(n.se, nodeX + half, nodeY + half, window, found);
+}
+
+bool HashLife::Bounds(int64_t x, int64_t y, int64_t width, int64_t height, int64_t& left, int64_t& top, int64_t& right, int64_t& bottom) const
+{
+	Window found{ 0, 0, 0, 0 };
+	BoundsNode(_root, _originX, _originY, Window{ x, y, x + width, y + height }, found);
+	left = found.x0;
+	top = found.y0;
+	right = found.x1 - 1;
+	bottom = found.y1 - 1;
+	return found.x0 < found.x1;
+}
+
+void HashLife::AccumulateNode(NodeId id, int64_t nodeX, int64_t nodeY, const Window& window, uint64_t* bits) const
+{
+	const Node& n = _nodes[id];
+	const int64_t size = int64_t{ 1 } << n.level;
+	if (n.population == 0 || nodeX >= window.x1 || nodeY >= window.y1 || nodeX + size <= window.x0 || nodeY + size <= window.y0)
+	{
+		return;
+	}
+
+	if (n.level == 0)
+	{
+		bits[nodeX >> 6] |= uint64_t{ 1 } << (nodeX & 63);
+		return;
+	}
+
+	const int64_t half = size / 2;
+	AccumulateNode(n.nw, nodeX, nodeY, window, bits);
+	AccumulateNode(n.ne, nodeX + half, nodeY, window, bits);
+	AccumulateNode(n.sw, nodeX, nodeY + half, window, bits);
+	AccumulateNode(n.se, nodeX + half, nodeY + half, window, bits);
+}
+
+void HashLife::AccumulateRows(int64_t x, int64_t y, int64_t width, int64_t height, uint64_t* bits, bool previous) const
+{
+	const Window window{ x, y, x + width, y + height };
+	if (previous)
+	{
+		AccumulateNode(_previous, _previousX, _previousY, window, bits);
+		return;
+	}
+	AccumulateNode(_root, _originX, _originY, window, bits);
+}
+
+uint64_t HashLife::Hash() const
+{
+	// where the root is doesn't matter, moving it back to (0, 0) leaves the same hash for the same cells
+	return SplitMix::Mix(Power(East, _originX) * Power(South, _originY) * _nodes[_root].hash);
+}
+
+void HashLife::Mark(NodeId id)
+{
+	Node& node = _nodes[id];
+	if (node.marked)
+	{
+		return;
+	}
+
+	node.marked = true;
+	if (node.level > 0)
+	{
+		Mark(node.nw);
+		Mark(node.ne);
+		Mark(node.sw);
+		Mark(node.se);
+	}
+}
+
+void HashLife::CollectGarbage()
+{
+	for (Node& node : _nodes)
+	{
+		node.marked = false;
+	}
+
+	// the two cells, the empty squares and whatever the root still uses
+	_nodes[Dead].marked = true;
+	_nodes[Alive].marked = true;
+	for (const NodeId e : _empty)
+	{
+		Mark(e);
+	}
+	Mark(_root);
+
+	std::fill(_table.begin(), _table.end(), Invalid);
+	_tableCount = 0;
+	_free.clear();
+
+	for (NodeId id = Alive + 1; id < _nodes.size(); id++)
+	{
+		Node& node = _nodes[id];
+		if (!node.marked)
+		{
+			node.free = true;
+			node.result = Invalid;
+			_free.push_back(id);
+			continue;
+		}
+
+		// a remembered result is only worth keeping if its node survived too
+		if (node.result != Invalid && !_nodes[node.result].marked)
+		{
+			node.result = Invalid;
+		}
+		Insert(id);
+	}
+}
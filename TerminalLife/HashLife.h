@@ -0,0 +1,164 @@
+﻿#pragma once
+#include "Rule.h"
+
+// Hashlife: the plane is a quadtree where every distinct square is stored once (hash-consed),
+// and each square remembers what its centre looks like some generations later.
+// empty space and anything that repeats costs next to nothing, so huge jumps in time are cheap
+// the plane is unbounded, there is no wrap around. only plain B/S rules without B0 work
+class HashLife
+{
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId Invalid = ~NodeId{ 0 };
+
+private:
+    // level 0 is a single cell, a level n node is a 2^n square made of four level n-1 nodes
+    struct Node
+    {
+        NodeId nw = Invalid;
+        NodeId ne = Invalid;
+        NodeId sw = Invalid;
+        NodeId se = Invalid;
+        uint64_t population = 0;
+        // the sum of East^x * South^y over the live cells, (x, y) from the node's top left, see Hash()
+        uint64_t hash = 0;
+        // the centre 2^(level-1) square 2^resultStep generations later, Invalid if not known yet
+        NodeId result = Invalid;
+        uint8_t level = 0;
+        uint8_t resultStep = 0;
+        bool marked = false;
+        bool free = false;
+    };
+
+    static constexpr NodeId Dead = 0;
+    static constexpr NodeId Alive = 1;
+    static constexpr int MaxLevel = 60;
+
+    std::vector<Node> _nodes;
+    std::vector<NodeId> _free;
+    // open addressing table of every node above level 0, keyed by its four children
+    std::vector<NodeId> _table;
+    size_t _tableCount = 0;
+    // the canonical all dead node of every level
+    std::vector<NodeId> _empty;
+
+    NodeId _root = Invalid;
+    // plane coordinates of the top left corner of the root
+    int64_t _originX = 0;
+    int64_t _originY = 0;
+    // the root and its corner before the last Step, kept until the next one so the two can be compared
+    NodeId _previous = Invalid;
+    int64_t _previousX = 0;
+    int64_t _previousY = 0;
+    uint64_t _generation = 0;
+    PackedRule _rule{ 0b000001000, 0b000001100 };
+    size_t _maxNodes = size_t{ 1 } << 21;
+
+    static size_t Hash(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+    NodeId NewNode(const Node& node);
+    void Insert(NodeId id);
+    void Grow();
+    NodeId Join(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+    NodeId Empty(int level);
+    NodeId Centre(NodeId id);
+    NodeId Expand(NodeId id);
+    bool FitsInCentre(NodeId id) const;
+    NodeId Life4x4(NodeId id);
+    NodeId Successor(NodeId id, int step);
+    NodeId SetNode(NodeId id, int64_t x, int64_t y, bool alive);
+    void Mark(NodeId id);
+
+    // a part of the plane, x1 and y1 just past the end
+    struct Window
+    {
+        int64_t x0;
+        int64_t y0;
+        int64_t x1;
+        int64_t y1;
+    };
+
+    static Window Clip(const Window& window, int64_t x, int64_t y, int64_t size);
+    bool GetNode(NodeId id, int64_t nodeX, int64_t nodeY, int64_t x, int64_t y) const;
+    NodeId NodeAt(int level, int64_t x, int64_t y) const;
+    uint64_t CountNode(NodeId id, int64_t nodeX, int64_t nodeY, const Window& window) const;
+    void BoundsNode(NodeId id, int64_t nodeX, int64_t nodeY, const Window& window, Window& found) const;
+    void AccumulateNode(NodeId id, int64_t nodeX, int64_t nodeY, const Window& window, uint64_t* bits) const;
+    void ChangesNode(NodeId before, int64_t nodeX, int64_t nodeY, int aligned, const Window& window, uint64_t& born, uint64_t& dying) const;
+    void ChangesAligned(NodeId before, NodeId after, int64_t nodeX, int64_t nodeY, const Window& window, uint64_t& born, uint64_t& dying) const;
+
+    int Level() const
+    {
+        return _nodes[_root].level;
+    }
+
+public:
+    HashLife();
+
+    // B0 would fill the infinite empty plane in one step, no quadtree survives that
+    static bool Supports(const PackedRule& rule)
+    {
+        return (rule.birth & 1) == 0;
+    }
+
+    // forgets every remembered result, they were for the old rule
+    void SetRule(const PackedRule& rule);
+
+    // once the table holds more than this many nodes, the next step collects garbage first
+    void SetMaxNodes(size_t nodes)
+    {
+        _maxNodes = nodes;
+    }
+
+    void Clear();
+
+    void Set(int64_t x, int64_t y, bool alive);
+
+    bool Get(int64_t x, int64_t y) const;
+
+    // the cell before the last Step
+    bool GetPrevious(int64_t x, int64_t y) const;
+
+    // moves the whole plane 2^log2 generations forward in one go
+    void Step(int log2);
+
+    // any number of generations, one Step per set bit, so it takes log(generations) steps
+    void Advance(uint64_t generations);
+
+    // the rest look at a width x height window with its top left at (x, y), and only go down the tree
+    // where it overlaps the window and has something alive in it
+
+    // the live cells in the window
+    uint64_t Population(int64_t x, int64_t y, int64_t width, int64_t height) const;
+
+    // the cells in the window that came alive and died in the last Step. squares that are the same node
+    // before and after didn't change at all, so they get skipped without looking inside
+    void Changes(int64_t x, int64_t y, int64_t width, int64_t height, uint64_t& born, uint64_t& dying) const;
+
+    // the smallest rectangle holding every live cell in the window, right and bottom inclusive. false if there aren't any
+    bool Bounds(int64_t x, int64_t y, int64_t width, int64_t height, int64_t& left, int64_t& top, int64_t& right, int64_t& bottom) const;
+
+    // ORs the live cells in the window's rows together, column c goes to bit c % 64 of bits[c / 64]. x can't be negative.
+    // previous reads the plane as it was before the last Step
+    void AccumulateRows(int64_t x, int64_t y, int64_t width, int64_t height, uint64_t* bits, bool previous = false) const;
+
+    // a hash of the whole plane, 0 when it's empty. it only depends on which cells are alive,
+    // not on how big the root is or where it sits, so the same plane always hashes the same
+    uint64_t Hash() const;
+
+    uint64_t Generation() const
+    {
+        return _generation;
+    }
+
+    uint64_t Population() const
+    {
+        return _nodes[_root].population;
+    }
+
+    size_t NodeCount() const
+    {
+        return _nodes.size() - _free.size();
+    }
+
+    void CollectGarbage();
+};
@@ -0,0 +1,359 @@
+﻿#include "pch.h"
+#include "PatternFile.h"
+
+namespace
+{
+	// pulls characters straight off the stream's buffer, no lines or strings in between
+	class Reader
+	{
+	private:
+		std::streambuf* _buffer;
+
+	public:
+		explicit Reader(std::istream& in)
+			: _buffer(in.rdbuf())
+		{
+		}
+
+		// EOF at the end
+		int Peek()
+		{
+			return _buffer->sgetc();
+		}
+
+		int Next()
+		{
+			return _buffer->sbumpc();
+		}
+
+		// everything up to the end of the line, the newline gets eaten
+		std::string Line()
+		{
+			std::string line;
+			for (int c = Next(); c != EOF && c != '\n'; c = Next())
+			{
+				if (c != '\r')
+				{
+					line.push_back(static_cast<char>(c));
+				}
+			}
+			return line;
+		}
+
+		void SkipLine()
+		{
+			for (int c = Next(); c != EOF && c != '\n'; c = Next())
+			{
+			}
+		}
+	};
+
+	std::string_view Trim(std::string_view text)
+	{
+		while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+		{
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+		{
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+
+	// wraps and sets one live cell
+	void SetLive(Board& board, int64_t x, int64_t y)
+	{
+		const int64_t width = board.Width();
+		const int64_t height = board.Height();
+		board.SetCell(static_cast<int>(((x % width) + width) % width), static_cast<int>(((y % height) + height) % height), Cell::State::Live);
+	}
+
+	// x = 3, y = 3, rule = B3/S23
+	bool ParseHeader(std::string_view header, PatternFile::Info& info)
+	{
+		while (!header.empty())
+		{
+			const size_t comma = header.find(',');
+			const std::string_view field = header.substr(0, comma);
+			header = (comma == std::string_view::npos) ? std::string_view() : header.substr(comma + 1);
+
+			const size_t equals = field.find('=');
+			if (equals == std::string_view::npos)
+			{
+				return false;
+			}
+			const std::string_view key = Trim(field.substr(0, equals));
+			const std::string_view value = Trim(field.substr(equals + 1));
+
+			if (key == "x" || key == "y")
+			{
+				int& size = (key == "x") ? info.width : info.height;
+				const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), size);
+				if (error != std::errc() || end != value.data() + value.size() || size < 0)
+				{
+					return false;
+				}
+			}
+			else if (key == "rule")
+			{
+				info.rule = value;
+			}
+		}
+		return true;
+	}
+
+	bool LoadRle(Reader& reader, Board& board, int x, int y, PatternFile::Info& info)
+	{
+		// comment lines, then the header
+		bool header = false;
+		while (!header && reader.Peek() != EOF)
+		{
+			const std::string line = reader.Line();
+			const std::string_view text = Trim(line);
+			if (text.empty())
+			{
+				continue;
+			}
+			if (text[0] == '#')
+			{
+				if (text.size() > 1 && text[1] == 'N')
+				{
+					info.name = Trim(text.substr(2));
+				}
+				continue;
+			}
+			if (!ParseHeader(text, info))
+			{
+				return false;
+			}
+			header = true;
+		}
+		if (!header)
+		{
+			return false;
+		}
+
+		// b and . are dead, o and the other letters (states of multi-state rules) live, $ ends a row, ! the pattern
+		int64_t cx = 0;
+		int64_t cy = 0;
+		int64_t count = 0;
+		for (int c = reader.Next(); c != EOF; c = reader.Next())
+		{
+			if (c >= '0' && c <= '9')
+			{
+				count = (count * 10) + (c - '0');
+				if (count > std::numeric_limits<int>::max())
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const int64_t run = (count == 0) ? 1 : count;
+			count = 0;
+			if (c == '!')
+			{
+				break;
+			}
+			else if (c == '$')
+			{
+				cx = 0;
+				cy += run;
+			}
+			else if (c == 'b' || c == '.')
+			{
+				cx += run;
+			}
+			else if (std::isalpha(c))
+			{
+				for (int64_t i = 0; i < run; i++)
+				{
+					SetLive(board, x + cx + i, y + cy);
+				}
+				cx += run;
+				info.live += run;
+			}
+			else if (c == '#')
+			{
+				// some writers put comments after the pattern starts
+				reader.SkipLine();
+			}
+			else if (!std::isspace(c))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool LoadPlaintext(Reader& reader, Board& board, int x, int y, PatternFile::Info& info)
+	{
+		int64_t cx = 0;
+		int64_t cy = 0;
+		for (int c = reader.Next(); c != EOF; c = reader.Next())
+		{
+			// ! starts a comment, but only at the start of a line
+			if (cx == 0 && c == '!')
+			{
+				const std::string line = reader.Line();
+				const std::string_view text = Trim(line);
+				if (text.starts_with("Name:"))
+				{
+					info.name = Trim(text.substr(5));
+				}
+				continue;
+			}
+
+			if (c == '\n')
+			{
+				cx = 0;
+				cy++;
+				info.height = static_cast<int>(std::min<int64_t>(cy, std::numeric_limits<int>::max()));
+			}
+			else if (c == 'O' || c == '*')
+			{
+				SetLive(board, x + cx, y + cy);
+				info.live++;
+				cx++;
+				info.width = static_cast<int>(std::max<int64_t>(info.width, std::min<int64_t>(cx, std::numeric_limits<int>::max())));
+			}
+			else if (c == '.')
+			{
+				cx++;
+			}
+			else if (c != '\r' && !std::isspace(c))
+			{
+				return false;
+			}
+		}
+
+		// the last row doesn't need a newline
+		if (cx > 0)
+		{
+			info.height = static_cast<int>(std::min<int64_t>(cy + 1, std::numeric_limits<int>::max()));
+		}
+		return true;
+	}
+
+	// keeps RLE lines under the 70 characters the format asks for
+	class RleWriter
+	{
+	private:
+		std::ostream& _out;
+		int _column = 0;
+
+	public:
+		explicit RleWriter(std::ostream& out)
+			: _out(out)
+		{
+		}
+
+		void Run(int64_t count, char tag)
+		{
+			if (count <= 0)
+			{
+				return;
+			}
+
+			char text[24];
+			char* end = text;
+			if (count > 1)
+			{
+				end = std::to_chars(text, text + sizeof(text) - 1, count).ptr;
+			}
+			*end++ = tag;
+
+			const int length = static_cast<int>(end - text);
+			if (_column + length > 70)
+			{
+				_out.put('\n');
+				_column = 0;
+			}
+			_out.write(text, length);
+			_column += length;
+		}
+
+		void End()
+		{
+			_out << "!\n";
+		}
+	};
+}
+
+std::optional<PatternFile::Info> PatternFile::Load(std::istream& in, Board& board, int x, int y)
+{
+	Reader reader(in);
+
+	// skip blank lines, then the first character says which kind of file it is
+	while (reader.Peek() != EOF && std::isspace(reader.Peek()))
+	{
+		reader.Next();
+	}
+
+	Info info;
+	const int first = reader.Peek();
+	const bool plaintext = first == '!' || first == '.' || first == 'O' || first == '*';
+	const bool ok = plaintext ? LoadPlaintext(reader, board, x, y, info) : LoadRle(reader, board, x, y, info);
+
+	// the counts have to agree with whatever got set, even if the file was bad half way through
+	board.Recount();
+	if (!ok || first == EOF)
+	{
+		return std::nullopt;
+	}
+	return info;
+}
+
+void PatternFile::Save(std::ostream& out, const Board& board, std::string_view rule)
+{
+	out << "#C generation " << board.Generation() << "\n"
+		<< "x = " << board.Width() << ", y = " << board.Height() << ", rule = " << rule << "\n";
+
+	RleWriter writer(out);
+	std::vector<uint64_t> bits((static_cast<size_t>(board.Width()) + 63) / 64);
+
+	// empty rows pile up into one $ run, dead cells at the end of a row are never written
+	int64_t rows = 0;
+	for (int y = 0; y < board.Height(); y++)
+	{
+		board.LiveRow(y, bits.data());
+
+		int x = 0;
+		bool first = true;
+		while (x < board.Width())
+		{
+			// the next live cell, skipping empty words whole
+			int w = x >> 6;
+			uint64_t word = bits[w] & (~uint64_t{ 0 } << (x & 63));
+			while (word == 0 && ++w < static_cast<int>(bits.size()))
+			{
+				word = bits[w];
+			}
+			if (word == 0)
+			{
+				break;
+			}
+			const int live = (w * 64) + std::countr_zero(word);
+
+			// and where that run of live cells stops
+			int dead = live;
+			while (dead < board.Width() && ((bits[dead >> 6] >> (dead & 63)) & 1))
+			{
+				dead++;
+			}
+
+			if (first)
+			{
+				writer.Run(rows, '$');
+				rows = 0;
+				first = false;
+			}
+			writer.Run(live - x, 'b');
+			writer.Run(dead - live, 'o');
+			x = dead;
+		}
+		rows++;
+	}
+	writer.End();
+}
@@ -0,0 +1,27 @@
+﻿#pragma once
+#include "Board.h"
+
+// reads and writes the usual Life pattern files
+// RLE (#N name, x = 3, y = 3, rule = B3/S23, then runs like 2bo$obo!) and plaintext .cells (!Name: ..., then .O rows)
+// files are read a character at a time and go straight onto the board, so big patterns never sit in memory as text
+class PatternFile
+{
+public:
+    struct Info
+    {
+        std::string name;
+        // from the RLE header, plaintext just has the extent of the rows read
+        int width = 0;
+        int height = 0;
+        // empty if the file didn't say
+        std::string rule;
+        int64_t live = 0;
+    };
+
+    // sets the live cells of the pattern in in with its top left at (x, y), wrapping at the edges
+    // cells already on the board stay. returns nothing if in isn't a pattern this can read
+    static std::optional<Info> Load(std::istream& in, Board& board, int x, int y);
+
+    // the current generation of the whole board as RLE, a row at a time from the live bits
+    static void Save(std::ostream& out, const Board& board, std::string_view rule);
+};
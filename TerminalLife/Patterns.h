@@ -0,0 +1,44 @@
+﻿#pragma once
+
+// a few well known starting patterns in plaintext, O is alive and anything else is dead
+struct Pattern
+{
+    std::string_view name;
+    std::string_view cells;
+};
+
+namespace Patterns
+{
+    inline constexpr Pattern Glider{ "glider", ".O.\n..O\nOOO" };
+    inline constexpr Pattern Lwss{ "lwss", ".O..O\nO....\nO...O\nOOOO." };
+    inline constexpr Pattern RPentomino{ "r-pentomino", ".OO\nOO.\n.O." };
+    // dies out after 130 generations
+    inline constexpr Pattern Diehard{ "diehard", "......O.\nOO......\n.O...OOO" };
+    // takes 5206 generations to settle
+    inline constexpr Pattern Acorn{ "acorn", ".O.....\n...O...\nOO..OOO" };
+    inline constexpr Pattern GosperGliderGun{ "gosper-gun",
+        "........................O...........\n"
+        "......................O.O...........\n"
+        "............OO......OO............OO\n"
+        "...........O...O....OO............OO\n"
+        "OO........O.....O...OO..............\n"
+        "OO........O...O.OO....O.O...........\n"
+        "..........O.....O.......O...........\n"
+        "...........O...O....................\n"
+        "............OO......................" };
+
+    inline constexpr const Pattern* All[] = { &Glider, &Lwss, &RPentomino, &Diehard, &Acorn, &GosperGliderGun };
+
+    // nullptr if there's no pattern by that name
+    inline const Pattern* Find(std::string_view name)
+    {
+        for (const Pattern* pattern : All)
+        {
+            if (pattern->name == name)
+            {
+                return pattern;
+            }
+        }
+        return nullptr;
+    }
+}
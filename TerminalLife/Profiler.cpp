@@ -0,0 +1,129 @@
+﻿#include "pch.h"
+#include "Profiler.h"
+
+namespace
+{
+	// a small number per thread for the trace, in the order threads first get timed
+	uint32_t ThreadNumber()
+	{
+		static std::atomic<uint32_t> s_next = 1;
+		thread_local const uint32_t number = s_next++;
+		return number;
+	}
+}
+
+int Profiler::Bucket(int64_t ns)
+{
+	if (ns < 4)
+	{
+		return 0;
+	}
+
+	// the octave and the two bits under the top one
+	const int octave = std::bit_width(static_cast<uint64_t>(ns)) - 1;
+	const int quarter = static_cast<int>((ns >> (octave - 2)) & 3);
+	return std::min(Buckets - 1, ((octave - 1) * 4) + quarter);
+}
+
+int64_t Profiler::BucketNs(int bucket)
+{
+	// Bucket puts everything under 4ns in bucket 0 and nothing in 1 to 3
+	if (bucket < 4)
+	{
+		return 0;
+	}
+
+	// the bottom of the bucket
+	const int octave = (bucket / 4) + 1;
+	return (int64_t{ 4 } + (bucket % 4)) << (octave - 2);
+}
+
+void Profiler::RecordImpl(Phase phase, Clock::time_point start, Clock::time_point end)
+{
+	const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	Histogram& histogram = _phases[static_cast<size_t>(phase)];
+	histogram.count.fetch_add(1, std::memory_order_relaxed);
+	histogram.totalNs.fetch_add(ns, std::memory_order_relaxed);
+	histogram.buckets[Bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+	if (ns > histogram.maxNs.load(std::memory_order_relaxed))
+	{
+		histogram.maxNs.store(ns, std::memory_order_relaxed);
+	}
+
+	if (_traceLimit.load(std::memory_order_relaxed) > 0)
+	{
+		std::lock_guard lock(_traceMutex);
+		if (_trace.size() < _traceLimit)
+		{
+			const int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - _epoch).count();
+			_trace.push_back(Event{ phase, ThreadNumber(), startNs, ns });
+		}
+	}
+}
+
+Profiler::Summary Profiler::SummarizeImpl(Phase phase) const
+{
+	const Histogram& histogram = _phases[static_cast<size_t>(phase)];
+	Summary summary;
+	summary.count = histogram.count.load(std::memory_order_relaxed);
+	if (summary.count == 0)
+	{
+		return summary;
+	}
+
+	summary.meanUs = static_cast<double>(histogram.totalNs.load(std::memory_order_relaxed)) / 1000.0 / static_cast<double>(summary.count);
+	summary.maxUs = static_cast<double>(histogram.maxNs.load(std::memory_order_relaxed)) / 1000.0;
+
+	// the buckets can be a few counts ahead of count while a phase is being recorded, that's fine for a HUD
+	const int64_t p50 = (summary.count + 1) / 2;
+	const int64_t p99 = summary.count - (summary.count / 100);
+	int64_t seen = 0;
+	for (int bucket = 0; bucket < Buckets; bucket++)
+	{
+		const int64_t before = seen;
+		seen += histogram.buckets[bucket].load(std::memory_order_relaxed);
+		if (before < p50 && seen >= p50)
+		{
+			summary.p50Us = static_cast<double>(BucketNs(bucket)) / 1000.0;
+		}
+		if (before < p99 && seen >= p99)
+		{
+			summary.p99Us = static_cast<double>(BucketNs(bucket)) / 1000.0;
+			break;
+		}
+	}
+	return summary;
+}
+
+bool Profiler::WriteTraceImpl(const std::string& path)
+{
+	std::lock_guard lock(_traceMutex);
+	std::ofstream file(path, std::ios::binary);
+
+	// complete events, times are in microseconds
+	file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (size_t i = 0; i < _trace.size(); i++)
+	{
+		const Event& event = _trace[i];
+		file << "{\"name\":\"" << Name(event.phase) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+			<< ",\"ts\":" << static_cast<double>(event.startNs) / 1000.0 << ",\"dur\":" << static_cast<double>(event.durationNs) / 1000.0
+			<< ((i + 1 < _trace.size()) ? "},\n" : "}\n");
+	}
+	file << "]}\n";
+	return static_cast<bool>(file);
+}
+
+std::string_view Profiler::Name(Phase phase)
+{
+	switch (phase)
+	{
+	case Phase::Rule: return "rule";
+	case Phase::Commit: return "commit";
+	case Phase::Capture: return "capture";
+	case Phase::Sleep: return "sleep";
+	case Phase::Draw: return "draw";
+	case Phase::Write: return "write";
+	case Phase::Count: break;
+	}
+	return "unknown";
+}
@@ -0,0 +1,136 @@
+﻿#pragma once
+
+// scoped timers around each phase of the loops, off by default
+// while off a ProfileScope is one relaxed load and a branch. while on, each phase keeps a histogram
+// the HUD can read from any thread, and with a trace started every scope is also kept as an event
+// that WriteTrace saves as Chrome trace-event JSON for Perfetto or chrome://tracing
+class Profiler
+{
+public:
+    enum class Phase { Rule, Commit, Capture, Sleep, Draw, Write, Count };
+
+    // a quarter octave per bucket, the top one takes anything over about 20 minutes
+    static constexpr int Buckets = 4 * 40;
+
+    struct Summary
+    {
+        int64_t count = 0;
+        double meanUs = 0.0;
+        double p50Us = 0.0;
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // every phase is only ever timed on one thread, the atomics are for whoever reads them
+    struct Histogram
+    {
+        std::atomic<int64_t> count = 0;
+        std::atomic<int64_t> totalNs = 0;
+        std::atomic<int64_t> maxNs = 0;
+        std::array<std::atomic<uint32_t>, Buckets> buckets{};
+    };
+
+    struct Event
+    {
+        Phase phase;
+        uint32_t thread;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    std::atomic<bool> _enabled = false;
+    Clock::time_point _epoch = Clock::now();
+    std::array<Histogram, static_cast<size_t>(Phase::Count)> _phases;
+
+    std::mutex _traceMutex;
+    std::vector<Event> _trace;
+    std::atomic<size_t> _traceLimit = 0;
+
+    static int Bucket(int64_t ns);
+    static int64_t BucketNs(int bucket);
+
+    void RecordImpl(Phase phase, Clock::time_point start, Clock::time_point end);
+    Summary SummarizeImpl(Phase phase) const;
+    bool WriteTraceImpl(const std::string& path);
+
+public:
+    static Profiler& Get()
+    {
+        static Profiler s_Instance;
+        return s_Instance;
+    }
+
+    Profiler() = default;
+    Profiler(const Profiler&) = delete;
+
+    static bool Enabled()
+    {
+        return Get()._enabled.load(std::memory_order_relaxed);
+    }
+
+    static void Enable(bool enabled)
+    {
+        Get()._enabled = enabled;
+    }
+
+    // keeps up to events scopes from now on for WriteTrace, and turns the profiler on
+    static void StartTrace(size_t events)
+    {
+        {
+            std::lock_guard lock(Get()._traceMutex);
+            Get()._trace.reserve(events);
+        }
+        Get()._traceLimit = events;
+        Enable(true);
+    }
+
+    static bool WriteTrace(const std::string& path)
+    {
+        return Get().WriteTraceImpl(path);
+    }
+
+    static void Record(Phase phase, Clock::time_point start, Clock::time_point end)
+    {
+        Get().RecordImpl(phase, start, end);
+    }
+
+    static Summary Summarize(Phase phase)
+    {
+        return Get().SummarizeImpl(phase);
+    }
+
+    static std::string_view Name(Phase phase);
+};
+
+// times the rest of the enclosing block as phase, if the profiler was on when it started
+class ProfileScope
+{
+private:
+    Profiler::Phase _phase;
+    bool _enabled;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    explicit ProfileScope(Profiler::Phase phase)
+        : _phase(phase), _enabled(Profiler::Enabled())
+    {
+        if (_enabled)
+        {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ProfileScope()
+    {
+        if (_enabled)
+        {
+            Profiler::Record(_phase, _start, std::chrono::steady_clock::now());
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,125 @@
+﻿#include "pch.h"
+#include "Renderer.h"
+#include "Frame.h"
+#include "FrameWriter.h"
+
+Renderer::Renderer(int top, double repaintThreshold)
+	: _top(top), _repaintThreshold(repaintThreshold)
+{
+}
+
+void Renderer::Invalidate()
+{
+	std::fill(_screen.begin(), _screen.end(), Unknown);
+}
+
+// emoji are two columns wide, braille one
+void Renderer::MoveTo(FrameWriter& out, int x, int y) const
+{
+	out.MoveTo((_zoom > 0) ? x : x * 2, _top + y);
+}
+
+void Renderer::AppendGlyph(FrameWriter& out, uint16_t glyph) const
+{
+	if (_zoom == 0)
+	{
+		out.Append(Cell::GetEmojiStateString(static_cast<Cell::State>(glyph)));
+		return;
+	}
+
+	// U+2800 plus the dot bits, always three bytes of utf8
+	const char braille[3] = { '\xe2', static_cast<char>(0xa0 | (glyph >> 6)), static_cast<char>(0x80 | (glyph & 0x3f)) };
+	out.Append(std::string_view(braille, sizeof(braille)));
+}
+
+void Renderer::Repaint(FrameWriter& out) const
+{
+	for (int y = 0; y < _height; y++)
+	{
+		MoveTo(out, 0, y);
+		for (int x = 0; x < _width; x++)
+		{
+			AppendGlyph(out, _frame[x + (y * _width)]);
+		}
+	}
+}
+
+// one cursor move per run of changed cells, short gaps of unchanged cells get drawn again
+void Renderer::Patch(FrameWriter& out) const
+{
+	for (int y = 0; y < _height; y++)
+	{
+		const uint16_t* frame = &_frame[static_cast<size_t>(y) * _width];
+		const uint16_t* screen = &_screen[static_cast<size_t>(y) * _width];
+
+		int x = 0;
+		while (x < _width)
+		{
+			if (frame[x] == screen[x])
+			{
+				x++;
+				continue;
+			}
+
+			// find where the run ends, it keeps going as long as the next change is close enough
+			int end = x + 1;
+			int gap = 0;
+			for (int i = end; i < _width && gap <= MaxGap; i++)
+			{
+				if (frame[i] != screen[i])
+				{
+					end = i + 1;
+					gap = 0;
+				}
+				else
+				{
+					gap++;
+				}
+			}
+
+			MoveTo(out, x, y);
+			for (int i = x; i < end; i++)
+			{
+				AppendGlyph(out, frame[i]);
+			}
+			x = end;
+		}
+	}
+}
+
+void Renderer::Present(const Frame& frame, FrameWriter& out)
+{
+	const size_t start = out.Size();
+	if (frame.width != _width || frame.height != _height || frame.zoom != _zoom)
+	{
+		_width = frame.width;
+		_height = frame.height;
+		_zoom = frame.zoom;
+		_screen.assign(static_cast<size_t>(_width) * _height, Unknown);
+		_frame.resize(_screen.size());
+
+		// the old picture may have been bigger or a different kind of glyph, wipe it
+		out.MoveTo(0, _top);
+		out.Append("\x1b[J");
+	}
+
+	int changed = 0;
+	for (size_t i = 0; i < _frame.size(); i++)
+	{
+		_frame[i] = frame.glyphs[i];
+		changed += _frame[i] != _screen[i];
+	}
+
+	_repainted = changed > _repaintThreshold * static_cast<double>(_frame.size());
+	if (_repainted)
+	{
+		Repaint(out);
+	}
+	else
+	{
+		Patch(out);
+	}
+
+	_screen.swap(_frame);
+	_bytes = out.Size() - start;
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+struct Frame;
+class FrameWriter;
+
+// draws the board with VT escape sequences. it remembers what is already on the screen and
+// only redraws the characters whose glyph changed, which is usually a small part of a big board
+// at zoom 0 every cell is an emoji two columns wide, zoomed out it's one braille character per 2x4 dots
+class Renderer
+{
+private:
+    // nothing we know of is on the screen there, so it always gets drawn
+    // every braille byte is a real glyph, so this sits outside them
+    static constexpr uint16_t Unknown = 0xffff;
+
+    // unchanged cells between two changes that are cheaper to draw again than to move the cursor over
+    static constexpr int MaxGap = 2;
+
+    // the glyph shown in every character now and in the frame being drawn
+    std::vector<uint16_t> _screen;
+    std::vector<uint16_t> _frame;
+    int _top;
+    int _width = 0;
+    int _height = 0;
+    int _zoom = 0;
+    // past this fraction of changed cells just redraw everything
+    double _repaintThreshold;
+    size_t _bytes = 0;
+    bool _repainted = false;
+
+    void MoveTo(FrameWriter& out, int x, int y) const;
+    void AppendGlyph(FrameWriter& out, uint16_t glyph) const;
+    void Repaint(FrameWriter& out) const;
+    void Patch(FrameWriter& out) const;
+
+public:
+    // top is the console row the board starts on, counting from 0
+    explicit Renderer(int top, double repaintThreshold = 0.5);
+
+    // adds what changed to the frame being written, the caller flushes it
+    void Present(const Frame& frame, FrameWriter& out);
+
+    // forget what's on the screen, the next Present redraws everything
+    void Invalidate();
+
+    // what the last Present added for the board
+    size_t BytesWritten() const
+    {
+        return _bytes;
+    }
+
+    bool Repainted() const
+    {
+        return _repainted;
+    }
+};
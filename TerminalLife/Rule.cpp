@@ -0,0 +1,147 @@
+﻿#include "pch.h"
+#include "Rule.h"
+
+namespace
+{
+	// a run of neighbor counts like "23", each digit sets its bit
+	bool ParseCounts(std::string_view digits, uint16_t& mask)
+	{
+		mask = 0;
+		for (const char c : digits)
+		{
+			if (c < '0' || c > '8')
+			{
+				return false;
+			}
+			mask |= static_cast<uint16_t>(1 << (c - '0'));
+		}
+		return true;
+	}
+
+	bool ParseStates(std::string_view digits, int& states)
+	{
+		if (digits.empty())
+		{
+			return false;
+		}
+
+		const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), states);
+		return error == std::errc() && end == digits.data() + digits.size() && states >= 2 && states <= Rule::MaxStates;
+	}
+}
+
+std::optional<Rule> Rule::Parse(std::string_view rulestring)
+{
+	// split on '/', there are two or three parts
+	std::vector<std::string_view> parts;
+	size_t start = 0;
+	while (true)
+	{
+		const size_t slash = rulestring.find('/', start);
+		parts.push_back(rulestring.substr(start, slash - start));
+		if (slash == std::string_view::npos)
+		{
+			break;
+		}
+		start = slash + 1;
+	}
+
+	if (parts.size() < 2 || parts.size() > 3)
+	{
+		return std::nullopt;
+	}
+
+	uint16_t birth = 0;
+	uint16_t survive = 0;
+	int states = 2;
+
+	const auto letter = [](std::string_view part) { return part.empty() ? '\0' : static_cast<char>(std::toupper(static_cast<unsigned char>(part[0]))); };
+
+	if (letter(parts[0]) == 'B' || letter(parts[0]) == 'S')
+	{
+		// B3/S23 or S23/B3, with an optional C or G state count
+		bool sawBirth = false;
+		bool sawSurvive = false;
+		for (size_t i = 0; i < parts.size(); i++)
+		{
+			const char which = letter(parts[i]);
+			const std::string_view digits = parts[i].substr(1);
+
+			if (which == 'B' && !sawBirth)
+			{
+				sawBirth = ParseCounts(digits, birth);
+				if (!sawBirth)
+				{
+					return std::nullopt;
+				}
+			}
+			else if (which == 'S' && !sawSurvive)
+			{
+				sawSurvive = ParseCounts(digits, survive);
+				if (!sawSurvive)
+				{
+					return std::nullopt;
+				}
+			}
+			else if (i == 2)
+			{
+				// B2/S/C3, B2/S/G3 or just B2/S/3
+				if (!ParseStates((which == 'C' || which == 'G') ? digits : parts[i], states))
+				{
+					return std::nullopt;
+				}
+			}
+			else
+			{
+				return std::nullopt;
+			}
+		}
+
+		if (!sawBirth || !sawSurvive)
+		{
+			return std::nullopt;
+		}
+	}
+	else
+	{
+		// the older survive/birth[/states] form
+		if (!ParseCounts(parts[0], survive) || !ParseCounts(parts[1], birth))
+		{
+			return std::nullopt;
+		}
+
+		if (parts.size() == 3 && !ParseStates(parts[2], states))
+		{
+			return std::nullopt;
+		}
+	}
+
+	return Rule(birth, survive, states);
+}
+
+std::string Rule::ToString() const
+{
+	std::string str = "B";
+	for (int count = 0; count < Counts; count++)
+	{
+		if ((_birth >> count) & 1)
+		{
+			str += static_cast<char>('0' + count);
+		}
+	}
+
+	str += "/S";
+	for (int count = 0; count < Counts; count++)
+	{
+		if ((_survive >> count) & 1)
+		{
+			str += static_cast<char>('0' + count);
+		}
+	}
+
+	if (!IsPlain())
+	{
+		str += "/C" + std::to_string(_states);
+	}
+	return str;
+}
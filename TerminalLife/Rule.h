@@ -0,0 +1,123 @@
+﻿#pragma once
+
+// plain B/S rule for the packed engine: bit n of birth/survive set means "n live neighbors"
+struct PackedRule
+{
+    uint16_t birth;
+    uint16_t survive;
+};
+
+// a Life-like rule in the usual rulestring notation, B3/S23 is Conway
+// Generations rules add a state count, B2/S/C3 is Brian's Brain. state 0 is dead, 1 is live,
+// and 2 and up are cells that are dying: they aren't counted as neighbors and can't be born into,
+// they just step towards 0 one state per generation
+// everything is baked into a table of next states indexed by (state, live neighbors)
+class Rule
+{
+public:
+    static constexpr int MaxStates = 64;
+    static constexpr int Counts = 9;
+
+private:
+    uint16_t _birth;
+    uint16_t _survive;
+    int _states;
+    std::array<uint8_t, MaxStates * Counts> _table;
+
+public:
+    constexpr Rule(uint16_t birth, uint16_t survive, int states = 2)
+        : _birth(birth), _survive(survive), _states(std::clamp(states, 2, MaxStates)), _table{}
+    {
+        for (int count = 0; count < Counts; count++)
+        {
+            _table[count] = ((_birth >> count) & 1) ? 1 : 0;
+            _table[Counts + count] = ((_survive >> count) & 1) ? 1 : ((_states > 2) ? 2 : 0);
+
+            for (int state = 2; state < _states; state++)
+            {
+                _table[(state * Counts) + count] = static_cast<uint8_t>((state + 1 < _states) ? state + 1 : 0);
+            }
+        }
+    }
+
+    // B3/S23, B36/S23, B2/S/C3, also the older S/B and S/B/C forms like 23/3 and 345/2/4
+    // returns nothing if the string isn't a rule
+    static std::optional<Rule> Parse(std::string_view rulestring);
+
+    std::string ToString() const;
+
+    constexpr uint8_t Next(uint8_t state, int count) const
+    {
+        return _table[(state * Counts) + count];
+    }
+
+    constexpr int States() const
+    {
+        return _states;
+    }
+
+    // plain B/S, no dying states, the only kind the packed engine can run
+    constexpr bool IsPlain() const
+    {
+        return _states == 2;
+    }
+
+    constexpr PackedRule Packed() const
+    {
+        return PackedRule{ _birth, _survive };
+    }
+};
+
+// a rule fixed at compile time, so the table is a constant the update loop can inline
+template <uint16_t Birth, uint16_t Survive, int StateCount = 2>
+struct StaticRule
+{
+    static constexpr Rule rule{ Birth, Survive, StateCount };
+
+    static constexpr uint8_t Next(uint8_t state, int count)
+    {
+        return rule.Next(state, count);
+    }
+
+    static constexpr int States()
+    {
+        return rule.States();
+    }
+
+    static constexpr bool IsPlain()
+    {
+        return rule.IsPlain();
+    }
+
+    static constexpr PackedRule Packed()
+    {
+        return rule.Packed();
+    }
+
+    static std::string ToString()
+    {
+        return rule.ToString();
+    }
+};
+
+// the built in rulesets, bit n set means n neighbors
+namespace Rules
+{
+    // https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life B3/S23
+    using Conway = StaticRule<0b000001000, 0b000001100>;
+
+    // https://en.wikipedia.org/wiki/Highlife_(cellular_automaton) B36/S23
+    using Highlife = StaticRule<0b001001000, 0b000001100>;
+
+    // https://en.wikipedia.org/wiki/Day_and_Night_(cellular_automaton) B3678/S34678
+    using DayAndNight = StaticRule<0b111001000, 0b111011000>;
+
+    // https://en.wikipedia.org/wiki/Seeds_(cellular_automaton) B2/S
+    using Seeds = StaticRule<0b000000100, 0b000000000>;
+
+    // https://en.wikipedia.org/wiki/Life_without_Death B3/S012345678
+    using LifeWithoutDeath = StaticRule<0b000001000, 0b111111111>;
+
+    // https://en.wikipedia.org/wiki/Brian%27s_Brain B2/S/C3
+    using BriansBrain = StaticRule<0b000000100, 0b000000000, 3>;
+}
@@ -0,0 +1,284 @@
+﻿#include "pch.h"
+#include "SparsePlane.h"
+#include "BitBoard.h"
+
+namespace
+{
+	// clockwise from north, the order Slot::around is in
+	constexpr int aroundX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	constexpr int aroundY[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+	enum { North, NorthEast, East, SouthEast, South, SouthWest, West, NorthWest };
+}
+
+void SparsePlane::Clear()
+{
+	_chunks.clear();
+	_slots.clear();
+	_changed.clear();
+	_population = 0;
+	_hash = 0;
+	_computed = 0;
+}
+
+void SparsePlane::Set(int64_t x, int64_t y, bool alive)
+{
+	const Coord coord = ChunkOf(x, y);
+	auto it = _chunks.find(Key(coord.x, coord.y));
+	if (it == _chunks.end())
+	{
+		if (!alive)
+		{
+			return;
+		}
+		it = _chunks.try_emplace(Key(coord.x, coord.y)).first;
+	}
+
+	Chunk& chunk = it->second;
+	const int r = y & (Size - 1);
+	uint64_t& word = chunk.rows[_current][r];
+	const uint64_t bit = uint64_t{ 1 } << (x & (Size - 1));
+	const int delta = static_cast<int>(alive) - static_cast<int>((word & bit) != 0);
+	const uint64_t hash = RowHash(it->first, r, word);
+	word = alive ? (word | bit) : (word & ~bit);
+	chunk.live += delta;
+	chunk.hash ^= hash ^ RowHash(it->first, r, word);
+	chunk.changed = true;
+	_population += delta;
+	_hash ^= hash ^ RowHash(it->first, r, word);
+}
+
+bool SparsePlane::Get(int64_t x, int64_t y) const
+{
+	const Chunk* chunk = Find(ChunkOf(x, y));
+	return chunk && ((chunk->rows[_current][y & (Size - 1)] >> (x & (Size - 1))) & 1);
+}
+
+void SparsePlane::SetWord(int64_t x, int64_t y, uint64_t word)
+{
+	const Coord coord = ChunkOf(x, y);
+	auto it = _chunks.find(Key(coord.x, coord.y));
+	if (it == _chunks.end())
+	{
+		if (word == 0)
+		{
+			return;
+		}
+		it = _chunks.try_emplace(Key(coord.x, coord.y)).first;
+	}
+
+	Chunk& chunk = it->second;
+	const int r = y & (Size - 1);
+	uint64_t& row = chunk.rows[_current][r];
+	const int delta = std::popcount(word) - std::popcount(row);
+	const uint64_t hash = RowHash(it->first, r, row) ^ RowHash(it->first, r, word);
+	row = word;
+	chunk.live += delta;
+	chunk.hash ^= hash;
+	chunk.changed = true;
+	_population += delta;
+	_hash ^= hash;
+}
+
+void SparsePlane::Extract(int64_t x, int64_t y, int width, int height, uint8_t* cells, int stride) const
+{
+	// a chunk at a time so each one only gets looked up once
+	const Coord first = ChunkOf(x, y);
+	const Coord last = ChunkOf(x + width - 1, y + height - 1);
+	for (int32_t cy = first.y; cy <= last.y; cy++)
+	{
+		for (int32_t cx = first.x; cx <= last.x; cx++)
+		{
+			const Chunk* chunk = Find(Coord{ cx, cy });
+			const int64_t x0 = std::max<int64_t>(x, int64_t{ cx } * Size);
+			const int64_t x1 = std::min<int64_t>(x + width, (int64_t{ cx } + 1) * Size);
+			const int64_t y0 = std::max<int64_t>(y, int64_t{ cy } * Size);
+			const int64_t y1 = std::min<int64_t>(y + height, (int64_t{ cy } + 1) * Size);
+
+			for (int64_t py = y0; py < y1; py++)
+			{
+				const uint64_t word = chunk ? chunk->rows[_current][py & (Size - 1)] : 0;
+				uint8_t* out = cells + ((py - y) * stride) - x;
+				for (int64_t px = x0; px < x1; px++)
+				{
+					out[px] = (word >> (px & (Size - 1))) & 1;
+				}
+			}
+		}
+	}
+}
+
+void SparsePlane::Prepare()
+{
+	// a live chunk keeps itself and whichever neighbors its edge cells could have something born in
+	// one that just emptied stays for a step too, its neighbors still have to see that it changed
+	_wanted.clear();
+	for (auto& [key, chunk] : _chunks)
+	{
+		chunk.keep = chunk.live > 0 || chunk.changed;
+		if (chunk.live == 0)
+		{
+			continue;
+		}
+
+		const Rows& rows = chunk.rows[_current];
+		uint64_t sides = 0;
+		for (const uint64_t row : rows)
+		{
+			sides |= row;
+		}
+
+		const Coord coord = FromKey(key);
+		const uint64_t top = rows[0];
+		const uint64_t bottom = rows[Size - 1];
+		const bool wants[8] =
+		{
+			top != 0, (top >> 63) != 0, (sides >> 63) != 0, (bottom >> 63) != 0,
+			bottom != 0, (bottom & 1) != 0, (sides & 1) != 0, (top & 1) != 0,
+		};
+		for (int n = 0; n < 8; n++)
+		{
+			if (wants[n])
+			{
+				_wanted.push_back(Key(coord.x + aroundX[n], coord.y + aroundY[n]));
+			}
+		}
+	}
+
+	for (const uint64_t key : _wanted)
+	{
+		// a new chunk starts out changed, so it gets computed
+		_chunks.try_emplace(key).first->second.keep = true;
+	}
+
+	// empty and out of reach, nothing can be born in them this step
+	std::erase_if(_chunks, [](const auto& entry)
+	{
+		return !entry.second.keep;
+	});
+
+	// a chunk can only change if it or one of its neighbors did last time
+	_slots.clear();
+	_slots.reserve(_chunks.size());
+	for (auto& [key, chunk] : _chunks)
+	{
+		Slot slot{ FromKey(key), &chunk, {}, chunk.changed };
+		for (int n = 0; n < 8; n++)
+		{
+			slot.around[n] = Find(Coord{ slot.coord.x + aroundX[n], slot.coord.y + aroundY[n] });
+			slot.active |= slot.around[n] && slot.around[n]->changed;
+		}
+		_slots.push_back(slot);
+	}
+}
+
+void SparsePlane::StepChunks(const PackedRule& rule, int begin, int end)
+{
+	static const Rows none{};
+	const int now = _current;
+	const int next = now ^ 1;
+
+	for (int s = begin; s < end; s++)
+	{
+		const Slot& slot = _slots[s];
+		Chunk& chunk = *slot.chunk;
+		const Rows& rows = chunk.rows[now];
+		Rows& out = chunk.rows[next];
+
+		// nothing around it changed, so neither does it. only its own changed flag gets written,
+		// the neighbors' were all read back in Prepare
+		if (!slot.active)
+		{
+			out = rows;
+			chunk.changed = false;
+			continue;
+		}
+
+		const auto side = [&slot, now](int n) -> const Rows&
+		{
+			return slot.around[n] ? slot.around[n]->rows[now] : none;
+		};
+		const Rows& north = side(North);
+		const Rows& south = side(South);
+		const Rows& east = side(East);
+		const Rows& west = side(West);
+
+		// row r of the chunk with the cell past either end, r can be -1 or Size to reach into the chunks above and below
+		const auto row = [&](int r, uint64_t& w, uint64_t& c, uint64_t& e)
+		{
+			uint64_t westCarry;
+			uint64_t eastCarry;
+			if (r < 0)
+			{
+				c = north[Size - 1];
+				westCarry = side(NorthWest)[Size - 1] >> 63;
+				eastCarry = side(NorthEast)[Size - 1] & 1;
+			}
+			else if (r == Size)
+			{
+				c = south[0];
+				westCarry = side(SouthWest)[0] >> 63;
+				eastCarry = side(SouthEast)[0] & 1;
+			}
+			else
+			{
+				c = rows[r];
+				westCarry = west[r] >> 63;
+				eastCarry = east[r] & 1;
+			}
+			w = (c << 1) | westCarry;
+			e = (c >> 1) | (eastCarry << 63);
+		};
+
+		uint64_t nw, n, ne, w, c, e, sw, so, se;
+		row(-1, nw, n, ne);
+		row(0, w, c, e);
+		// only the rows that changed need their hash redone
+		const uint64_t key = Key(slot.coord.x, slot.coord.y);
+		uint64_t changed = 0;
+		int live = 0;
+		for (int r = 0; r < Size; r++)
+		{
+			row(r + 1, sw, so, se);
+			const uint64_t result = BitBoard::NextWord(rule, nw, n, ne, w, c, e, sw, so, se);
+			out[r] = result;
+			changed |= result ^ c;
+			live += std::popcount(result);
+			if (result != c)
+			{
+				chunk.hash ^= RowHash(key, r, c) ^ RowHash(key, r, result);
+			}
+
+			nw = w; n = c; ne = e;
+			w = sw; c = so; e = se;
+		}
+		chunk.live = live;
+		chunk.changed = changed != 0;
+	}
+}
+
+void SparsePlane::Finish()
+{
+	_current ^= 1;
+	_population = 0;
+	_hash = 0;
+	_computed = 0;
+	_changed.clear();
+	for (const Slot& slot : _slots)
+	{
+		_population += slot.chunk->live;
+		_hash ^= slot.chunk->hash;
+		_computed += slot.active;
+		if (slot.chunk->changed)
+		{
+			_changed.push_back(slot.coord);
+		}
+	}
+}
+
+void SparsePlane::MarkAllChanged()
+{
+	for (auto& [key, chunk] : _chunks)
+	{
+		chunk.changed = true;
+	}
+}
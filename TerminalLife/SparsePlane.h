@@ -0,0 +1,155 @@
+﻿#pragma once
+#include "Rule.h"
+#include "SplitMix.h"
+
+// an unbounded plane stored as Size x Size chunks of bits in a hash map keyed by chunk coordinates
+// only chunks with something alive in them, or right next to something alive at their edge, exist at all,
+// so memory and the cost of a step follow the live area rather than any rectangle
+// plain B/S rules without B0, like HashLife. a chunk row is one word laid out like a BitBoard row
+class SparsePlane
+{
+public:
+    // cells per side of a chunk
+    static constexpr int Size = 64;
+
+    struct Coord
+    {
+        int32_t x;
+        int32_t y;
+    };
+
+private:
+    using Rows = std::array<uint64_t, Size>;
+
+    struct Chunk
+    {
+        // this generation and the next, _current says which is which
+        Rows rows[2]{};
+        int live = 0;
+        // RowHash of every row XORed together, 0 while it's empty
+        uint64_t hash = 0;
+        // changed in the last step or by Set, so it and its neighbors get computed next step
+        bool changed = true;
+        // live, just changed, or a live neighbor's edge cells could be born into it. Prepare drops the rest
+        bool keep = false;
+    };
+
+    // a chunk to compute and its eight neighbors clockwise from north, nullptr where there's nothing
+    struct Slot
+    {
+        Coord coord;
+        Chunk* chunk;
+        std::array<const Chunk*, 8> around;
+        bool active;
+    };
+
+    // unordered_map never moves its elements, so the Slots can point straight at them
+    std::unordered_map<uint64_t, Chunk> _chunks;
+    std::vector<Slot> _slots;
+    std::vector<uint64_t> _wanted;
+    std::vector<Coord> _changed;
+    int _current = 0;
+    uint64_t _population = 0;
+    uint64_t _hash = 0;
+    int _computed = 0;
+
+    static uint64_t Key(int32_t cx, int32_t cy)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    static Coord FromKey(uint64_t key)
+    {
+        return Coord{ static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xffffffff) };
+    }
+
+    // where a row is on the plane and what's in it, 0 for an empty row so empty chunks don't count
+    static uint64_t RowHash(uint64_t key, int r, uint64_t row)
+    {
+        return (row == 0) ? 0 : SplitMix::Mix(SplitMix::At(key, r) ^ row);
+    }
+
+    // the chunk holding plane cell (x, y), which works for negative cells too
+    static Coord ChunkOf(int64_t x, int64_t y)
+    {
+        return Coord{ static_cast<int32_t>(x >> 6), static_cast<int32_t>(y >> 6) };
+    }
+
+    const Chunk* Find(Coord coord) const
+    {
+        const auto it = _chunks.find(Key(coord.x, coord.y));
+        return (it == _chunks.end()) ? nullptr : &it->second;
+    }
+
+public:
+    // B0 would fill the whole infinite plane in one step
+    static bool Supports(const PackedRule& rule)
+    {
+        return (rule.birth & 1) == 0;
+    }
+
+    void Clear();
+
+    void Set(int64_t x, int64_t y, bool alive);
+
+    bool Get(int64_t x, int64_t y) const;
+
+    // writes plane cells x to x+63 of row y at once, x a multiple of Size. an empty word doesn't add a chunk
+    void SetWord(int64_t x, int64_t y, uint64_t word);
+
+    // copies a width x height window with its top left at (x, y) into cells, rows stride apart, 1 for live
+    void Extract(int64_t x, int64_t y, int width, int height, uint8_t* cells, int stride) const;
+
+    // a step in three parts. Prepare adds the chunks the step can reach and drops the ones it can't,
+    // StepChunks(begin, end) computes chunks [begin, end) of the next generation and can run on several threads
+    // at once, and Finish makes that generation current
+    void Prepare();
+
+    int Chunks() const
+    {
+        return static_cast<int>(_slots.size());
+    }
+
+    void StepChunks(const PackedRule& rule, int begin, int end);
+
+    void Finish();
+
+    void Step(const PackedRule& rule)
+    {
+        Prepare();
+        StepChunks(rule, 0, Chunks());
+        Finish();
+    }
+
+    // every chunk gets computed next step, after a rule change
+    void MarkAllChanged();
+
+    uint64_t Population() const
+    {
+        return _population;
+    }
+
+    // a hash of every live cell on the plane, 0 when it's empty. kept up to date a row at a time,
+    // so like Population it costs nothing to ask for
+    uint64_t Hash() const
+    {
+        return _hash;
+    }
+
+    // chunks whose cells the last step changed
+    const std::vector<Coord>& Changed() const
+    {
+        return _changed;
+    }
+
+    size_t ChunkCount() const
+    {
+        return _chunks.size();
+    }
+
+    // the fraction of chunks the last step actually computed, the rest were still lifes or empty
+    double ActiveRatio() const
+    {
+        return _slots.empty() ? 1.0 : static_cast<double>(_computed) / static_cast<double>(_slots.size());
+    }
+};
@@ -0,0 +1,42 @@
+﻿#pragma once
+
+// SplitMix64 used as a counter based generator, value i of a stream only depends on the seed and i,
+// so any thread can make any part of the board in any order and always get the same thing
+class SplitMix
+{
+public:
+    static constexpr uint64_t Mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr uint64_t At(uint64_t seed, uint64_t counter)
+    {
+        return Mix(seed + ((counter + 1) * 0x9e3779b97f4a7c15));
+    }
+
+    // 64 independent bits, each one set with probability fraction / 65536
+    // built from the binary digits of fraction, lowest first: a 1 ORs in a fresh random word and
+    // a 0 ANDs one in, which lands exactly on the probability. 0.25 only takes two words
+    static constexpr uint64_t Bits(uint64_t seed, uint64_t counter, uint32_t fraction)
+    {
+        if (fraction >= 65536)
+        {
+            return ~uint64_t{ 0 };
+        }
+        if (fraction == 0)
+        {
+            return 0;
+        }
+
+        uint64_t bits = 0;
+        for (int digit = std::countr_zero(fraction); digit < 16; digit++)
+        {
+            const uint64_t random = At(seed, (counter * 16) + digit);
+            bits = ((fraction >> digit) & 1) ? (bits | random) : (bits & random);
+        }
+        return bits;
+    }
+};
@@ -0,0 +1,14 @@
+﻿#include "pch.h"
+#include "Statistics.h"
+
+void History::WriteCsv(std::ostream& out) const
+{
+	out << "generation,live,born,dying,old,left,top,right,bottom\n";
+	for (size_t i = 0; i < Size(); i++)
+	{
+		const Sample& sample = (*this)[i];
+		out << sample.generation << ',' << sample.counts.live << ',' << sample.counts.born << ',' << sample.counts.dying << ','
+			<< sample.counts.old << ',' << sample.bounds.left << ',' << sample.bounds.top << ',' << sample.bounds.right << ','
+			<< sample.bounds.bottom << '\n';
+	}
+}
@@ -0,0 +1,89 @@
+﻿#pragma once
+#include "Cell.h"
+
+// the smallest rectangle holding every live cell, inclusive. Empty() when there aren't any
+struct Bounds
+{
+    int left = 0;
+    int top = 0;
+    int right = -1;
+    int bottom = -1;
+
+    bool Empty() const
+    {
+        return right < left;
+    }
+
+    int Width() const
+    {
+        return Empty() ? 0 : right - left + 1;
+    }
+
+    int Height() const
+    {
+        return Empty() ? 0 : bottom - top + 1;
+    }
+};
+
+// what one generation looked like, worked out when somebody asks rather than kept up on every step
+// born and dying are how the board got to this generation from the one before
+struct Sample
+{
+    int64_t generation = 0;
+    CellCounts counts;
+    Bounds bounds;
+};
+
+// the last so many samples, oldest first. a full history drops its oldest sample for each new one
+class History
+{
+private:
+    std::vector<Sample> _samples;
+    size_t _next = 0;
+    size_t _size = 0;
+
+public:
+    History() = default;
+
+    explicit History(size_t capacity)
+        : _samples(capacity)
+    {
+    }
+
+    size_t Capacity() const
+    {
+        return _samples.size();
+    }
+
+    size_t Size() const
+    {
+        return _size;
+    }
+
+    // 0 is the oldest, Size() - 1 the newest
+    const Sample& operator[](size_t i) const
+    {
+        return _samples[(_next + _samples.size() - _size + i) % _samples.size()];
+    }
+
+    void Push(const Sample& sample)
+    {
+        if (_samples.empty())
+        {
+            return;
+        }
+
+        _samples[_next] = sample;
+        _next = (_next + 1) % _samples.size();
+        _size = std::min(_size + 1, _samples.size());
+    }
+
+    void Clear()
+    {
+        _next = 0;
+        _size = 0;
+    }
+
+    // one row per sample, oldest first, with a header row
+    void WriteCsv(std::ostream& out) const;
+};
@@ -0,0 +1,552 @@
+﻿#include "pch.h"
+#include "Stripes.h"
+#include "SplitMix.h"
+#include "Cell.h"
+
+namespace
+{
+	// sleeps while word is still expected, for a while at most. a futex on Linux, the shared kind so it works
+	// between processes, and a short nap anywhere else
+	void SleepWhile(std::atomic<uint32_t>& word, uint32_t expected)
+	{
+#if defined(__linux__) && !defined(_WIN32)
+		const timespec timeout{ 0, 50 * 1000 * 1000 };
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+		if (word.load(std::memory_order_acquire) == expected)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+#endif
+	}
+
+	// wakes everybody in SleepWhile on word
+	void WakeAll(std::atomic<uint32_t>& word)
+	{
+#if defined(__linux__) && !defined(_WIN32)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr, nullptr, 0);
+#else
+		(void)word;
+#endif
+	}
+
+	// waits until word isn't expected any more, false if alive() says it never will be
+	// the stripes are usually only moments apart so it spins for a bit, after that it sleeps so that
+	// a coordinator that's paused or waiting on the next frame doesn't cost every worker a core
+	bool WaitForChange(std::atomic<uint32_t>& word, uint32_t expected, const auto& alive)
+	{
+		for (int spins = 0; spins < 1024; spins++)
+		{
+			if (word.load(std::memory_order_acquire) != expected)
+			{
+				return true;
+			}
+			std::this_thread::yield();
+		}
+
+		while (word.load(std::memory_order_acquire) == expected)
+		{
+			if (!alive())
+			{
+				return false;
+			}
+			SleepWhile(word, expected);
+		}
+		return true;
+	}
+
+	// a barrier in the shared memory, nobody gets out of Wait until all parties are in it
+	struct Barrier
+	{
+		std::atomic<uint32_t> arrived = 0;
+		std::atomic<uint32_t> round = 0;
+
+		// false if alive() says one of the parties is never coming
+		bool Wait(uint32_t parties, const auto& alive)
+		{
+			const uint32_t current = round.load(std::memory_order_acquire);
+			if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties)
+			{
+				arrived.store(0, std::memory_order_relaxed);
+				round.store(current + 1, std::memory_order_release);
+				WakeAll(round);
+				return true;
+			}
+			return WaitForChange(round, current, alive);
+		}
+	};
+
+	// a worker's coordinator is its parent, once that's changed nobody is going to give it any more commands
+	bool IsParent(int parent)
+	{
+#ifdef _WIN32
+		(void)parent;
+		return true;
+#else
+		return static_cast<int>(getppid()) == parent;
+#endif
+	}
+
+	// it has to work between processes, which only lock free atomics do
+	static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+	enum class Order : uint32_t
+	{
+		Step,
+		Gather,
+		Count,
+		Quit
+	};
+
+	enum Edge
+	{
+		Top,
+		Bottom
+	};
+
+	// a stripe's edge rows go round a ring of this many slots, one per generation. the exchange barrier
+	// keeps every stripe within a generation of the others, so by the time anybody writes a slot again
+	// everybody has read what was in it
+	constexpr int Slots = 2;
+}
+
+// the start of the shared memory. after it come the rings, Slots rows for each edge of each stripe,
+// and then MaxDots bytes of dots for Capture
+struct Stripes::Shared
+{
+	// the coordinator and every worker, at the start and end of each command
+	Barrier command;
+	// just the workers, once a generation between writing their edges and reading the others'
+	Barrier exchange;
+
+	int processes = 0;
+	int words = 0;
+
+	// what the command is
+	Order order = Order::Quit;
+	// Step: from generation, generations of them
+	int64_t generation = 0;
+	int64_t generations = 0;
+	// Gather: dots across and rows down of block x block squares, starting with the one at (x, y)
+	int x = 0;
+	int y = 0;
+	int block = 1;
+	int dots = 0;
+	int rows = 0;
+	// Gather and Count: the live cells in each stripe
+	std::array<int64_t, MaxProcesses> live{};
+	// Count: Board::Hash goes through the cells in order, so the stripes take turns carrying it on
+	std::atomic<uint32_t> turn = 0;
+	uint64_t hash = 0;
+
+	static size_t RingsOffset()
+	{
+		return (sizeof(Shared) + 63) & ~size_t{ 63 };
+	}
+
+	static size_t Bytes(int processes, int words)
+	{
+		return RingsOffset() + (static_cast<size_t>(processes) * 2 * Slots * words * sizeof(uint64_t)) + MaxDots;
+	}
+
+	// where stripe's edge row for generation goes
+	uint64_t* EdgeRow(int stripe, Edge edge, int64_t generation)
+	{
+		const size_t row = (((static_cast<size_t>(stripe) * 2) + edge) * Slots) + static_cast<size_t>(generation % Slots);
+		return reinterpret_cast<uint64_t*>(reinterpret_cast<uint8_t*>(this) + RingsOffset()) + (row * words);
+	}
+
+	uint8_t* Dots()
+	{
+		return reinterpret_cast<uint8_t*>(this) + Bytes(processes, words) - MaxDots;
+	}
+};
+
+Stripes::~Stripes()
+{
+#ifndef _WIN32
+	if (!_shared)
+	{
+		return;
+	}
+
+	// the workers only all come to a Quit if they all got started
+	if (static_cast<int>(_workers.size()) == _processes && WorkersAlive())
+	{
+		_shared->order = Order::Quit;
+		Command();
+	}
+	else
+	{
+		for (const int worker : _workers)
+		{
+			kill(worker, SIGKILL);
+		}
+	}
+
+	for (const int worker : _workers)
+	{
+		waitpid(worker, nullptr, 0);
+	}
+	munmap(_shared, _bytes);
+#endif
+}
+
+std::unique_ptr<Stripes> Stripes::Start(int width, int height, int processes, Topology topology, PackedRule rule, double density, uint64_t seed)
+{
+	if (processes < 1 || processes > MaxProcesses || processes > height)
+	{
+		std::cout << "TerminalLife: " << processes << " processes is more than the " << std::min(height, MaxProcesses) << " stripes there can be" << std::endl;
+		return nullptr;
+	}
+
+#ifdef _WIN32
+	(void)width, (void)topology, (void)rule, (void)density, (void)seed;
+	std::cout << "TerminalLife: --processes needs fork and POSIX shared memory, which Windows doesn't have" << std::endl;
+	return nullptr;
+#else
+	std::unique_ptr<Stripes> stripes(new Stripes());
+	stripes->_width = width;
+	stripes->_height = height;
+	stripes->_processes = processes;
+	stripes->_topology = topology;
+	stripes->_rule = rule;
+
+	// the name only has to last until it's mapped, the workers get the mapping when they fork
+	const int words = (width + 63) / 64;
+	const size_t bytes = Shared::Bytes(processes, words);
+	const std::string name = "/TerminalLife-" + std::to_string(getpid());
+	const int file = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (file < 0)
+	{
+		std::cout << "TerminalLife: couldn't make shared memory for the stripes: " << std::strerror(errno) << std::endl;
+		return nullptr;
+	}
+	void* memory = (ftruncate(file, static_cast<off_t>(bytes)) == 0) ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+	const int error = errno;
+	close(file);
+	shm_unlink(name.c_str());
+	if (memory == MAP_FAILED)
+	{
+		std::cout << "TerminalLife: couldn't map " << bytes / 1024 << " KB of shared memory for the stripes: " << std::strerror(error) << std::endl;
+		return nullptr;
+	}
+
+	stripes->_shared = new (memory) Shared();
+	stripes->_bytes = bytes;
+	stripes->_shared->processes = processes;
+	stripes->_shared->words = words;
+
+	// anything still buffered would come out once for every process
+	std::cout.flush();
+	const uint32_t fraction = static_cast<uint32_t>(std::clamp(std::lround(density * 65536.0), 0L, 65536L));
+	const int parent = static_cast<int>(getpid());
+	for (int stripe = 0; stripe < processes; stripe++)
+	{
+		const pid_t worker = fork();
+		if (worker == 0)
+		{
+			// none of the coordinator's cleanup is ours to run
+			stripes->Work(stripe, parent, fraction, seed);
+			_exit(0);
+		}
+		if (worker < 0)
+		{
+			std::cout << "TerminalLife: couldn't start worker " << stripe << ": " << std::strerror(errno) << std::endl;
+			return nullptr;
+		}
+		stripes->_workers.push_back(static_cast<int>(worker));
+	}
+	return stripes;
+#endif
+}
+
+bool Stripes::WorkersAlive()
+{
+#ifndef _WIN32
+	for (const int worker : _workers)
+	{
+		if (waitpid(worker, nullptr, WNOHANG) != 0)
+		{
+			return false;
+		}
+	}
+#endif
+	return true;
+}
+
+bool Stripes::Command()
+{
+	const auto alive = [this]() { return WorkersAlive(); };
+	const uint32_t parties = static_cast<uint32_t>(_processes) + 1;
+	if (!_shared->command.Wait(parties, alive))
+	{
+		return false;
+	}
+
+	// nobody's left to say they're done quitting
+	return (_shared->order == Order::Quit) || _shared->command.Wait(parties, alive);
+}
+
+void Stripes::Work(int stripe, int parent, uint32_t fraction, uint64_t seed)
+{
+	const auto alive = [parent]() { return IsParent(parent); };
+	const uint32_t parties = static_cast<uint32_t>(_processes);
+	const int y0 = StripeBegin(stripe);
+	const int rows = StripeBegin(stripe + 1) - y0;
+	const int words = _shared->words;
+
+	// the halos decide what's past the top and bottom, only left and right are up to the topology
+	BitBoard bits(_width, rows);
+	bits.SetTopology((_topology == Topology::Bounded) ? Topology::Bounded : Topology::Torus);
+	for (int y = 0; y < rows; y++)
+	{
+		for (int w = 0; w < words; w++)
+		{
+			bits.SetWord(y, w, SplitMix::Bits(seed, (static_cast<uint64_t>(y0 + y) * words) + w, fraction));
+		}
+	}
+	bits.Tiles().MarkAllActive();
+
+	// the row past an edge of the stripe is the other edge of the stripe next to it, or what the
+	// topology puts past the edge of the whole board
+	std::vector<uint64_t> above(words);
+	std::vector<uint64_t> below(words);
+	const auto halo = [this, words](std::vector<uint64_t>& out, const uint64_t* row, bool boardEdge)
+	{
+		if (!boardEdge || _topology == Topology::Torus)
+		{
+			std::copy(row, row + words, out.begin());
+			return;
+		}
+
+		std::fill(out.begin(), out.end(), 0);
+		for (int x = 0; _topology == Topology::Klein && x < _width; x++)
+		{
+			const int mirror = _width - 1 - x;
+			out[x >> 6] |= ((row[mirror >> 6] >> (mirror & 63)) & 1) << (x & 63);
+		}
+	};
+	const int up = (stripe + _processes - 1) % _processes;
+	const int down = (stripe + 1) % _processes;
+
+	std::vector<uint64_t> accumulated(words);
+	while (_shared->command.Wait(parties + 1, alive))
+	{
+		if (_shared->order == Order::Quit)
+		{
+			return;
+		}
+
+		if (_shared->order == Order::Step)
+		{
+			for (int64_t generation = _shared->generation; generation < _shared->generation + _shared->generations; generation++)
+			{
+				std::copy(bits.Row(0), bits.Row(0) + words, _shared->EdgeRow(stripe, Top, generation));
+				std::copy(bits.Row(rows - 1), bits.Row(rows - 1) + words, _shared->EdgeRow(stripe, Bottom, generation));
+				if (!_shared->exchange.Wait(parties, alive))
+				{
+					return;
+				}
+
+				halo(above, _shared->EdgeRow(up, Bottom, generation), stripe == 0);
+				halo(below, _shared->EdgeRow(down, Top, generation), stripe == _processes - 1);
+				bits.SetHalo(above.data(), below.data());
+				bits.StepRows(_rule, 0, rows);
+				bits.Tiles().Update();
+				bits.Swap();
+			}
+		}
+
+		if (_shared->order == Order::Gather || _shared->order == Order::Count)
+		{
+			_shared->live[stripe] = bits.Population();
+		}
+
+		if (_shared->order == Order::Count)
+		{
+			// wait for the stripe above to finish its rows, then carry on the way Board::Hash would
+			for (uint32_t turn = _shared->turn.load(std::memory_order_acquire); turn != static_cast<uint32_t>(stripe); turn = _shared->turn.load(std::memory_order_acquire))
+			{
+				if (!WaitForChange(_shared->turn, turn, alive))
+				{
+					return;
+				}
+			}
+
+			uint64_t hash = _shared->hash;
+			for (int y = 0; y < rows; y++)
+			{
+				for (int x = 0; x < _width; x++)
+				{
+					hash ^= static_cast<uint8_t>(bits.Get(x, y) ? Cell::State::Live : Cell::State::Dead);
+					hash *= 0x100000001b3;
+				}
+			}
+			_shared->hash = hash;
+			_shared->turn.store(static_cast<uint32_t>(stripe) + 1, std::memory_order_release);
+			WakeAll(_shared->turn);
+		}
+
+		if (_shared->order == Order::Gather)
+		{
+
+			// the dot rows that reach into this stripe, a dot can straddle two stripes so they both only ever set them
+			const int block = _shared->block;
+			const int x0 = _shared->x;
+			const int x1 = std::min(_width, x0 + (_shared->dots * block));
+			for (int r = 0; r < _shared->rows; r++)
+			{
+				const int top = std::max(y0, _shared->y + (r * block));
+				const int bottom = std::min(y0 + rows, _shared->y + ((r + 1) * block));
+				if (top >= bottom)
+				{
+					continue;
+				}
+
+				std::fill(accumulated.begin(), accumulated.end(), 0);
+				for (int y = top; y < bottom; y++)
+				{
+					const uint64_t* row = bits.Row(y - y0);
+					for (int i = x0 >> 6; i < words; i++)
+					{
+						accumulated[i] |= row[i];
+					}
+				}
+
+				uint8_t* dot = _shared->Dots() + (static_cast<size_t>(r) * _shared->dots);
+				for (int d = 0; d < _shared->dots; d++)
+				{
+					// any bit in [from, to) set
+					int from = x0 + (d * block);
+					const int to = std::min(x1, from + block);
+					bool any = false;
+					while (from < to && !any)
+					{
+						const int bit = from & 63;
+						const int n = std::min(64 - bit, to - from);
+						const uint64_t mask = (n == 64) ? ~uint64_t{ 0 } : (((uint64_t{ 1 } << n) - 1) << bit);
+						any = (accumulated[from >> 6] & mask) != 0;
+						from += n;
+					}
+					if (any)
+					{
+						std::atomic_ref<uint8_t>(dot[d]).store(1, std::memory_order_relaxed);
+					}
+				}
+			}
+		}
+
+		if (!_shared->command.Wait(parties + 1, alive))
+		{
+			return;
+		}
+	}
+}
+
+int64_t Stripes::Live() const
+{
+	int64_t live = 0;
+	for (int stripe = 0; stripe < _processes; stripe++)
+	{
+		live += _shared->live[stripe];
+	}
+	return live;
+}
+
+bool Stripes::Step(int64_t generations)
+{
+	_shared->order = Order::Step;
+	_shared->generation = _generation;
+	_shared->generations = generations;
+	if (!Command())
+	{
+		return false;
+	}
+	_generation += generations;
+	return true;
+}
+
+std::optional<Stripes::Tally> Stripes::Count()
+{
+	_shared->order = Order::Count;
+	_shared->turn.store(0, std::memory_order_relaxed);
+	_shared->hash = 0xcbf29ce484222325;
+	if (!Command())
+	{
+		return std::nullopt;
+	}
+
+	return Tally{ Live(), _shared->hash };
+}
+
+bool Stripes::Capture(Frame& frame, const Viewport& view)
+{
+	// just the characters the board actually reaches, and no more than fit in the dots
+	const int x0 = std::clamp(view.x, 0, _width - 1);
+	const int y0 = std::clamp(view.y, 0, _height - 1);
+	frame.zoom = view.zoom;
+	frame.width = std::clamp((_width - x0 + view.GlyphWidth() - 1) / view.GlyphWidth(), 0, view.GlyphColumns());
+	frame.height = std::clamp((_height - y0 + view.GlyphHeight() - 1) / view.GlyphHeight(), 0, view.GlyphRows());
+	const int across = (view.zoom > 0) ? 2 : 1;
+	const int down = (view.zoom > 0) ? 4 : 1;
+	frame.height = std::min(frame.height, static_cast<int>(MaxDots / (static_cast<size_t>(std::max(frame.width, 1)) * across * down)));
+	frame.glyphs.resize(static_cast<size_t>(frame.width) * frame.height);
+
+	// zoom 0 is a 1x1 block a character, which is just the cell
+	const int dots = frame.width * across;
+	const int rows = frame.height * down;
+	std::fill(_shared->Dots(), _shared->Dots() + (static_cast<size_t>(dots) * rows), uint8_t{ 0 });
+	_shared->order = Order::Gather;
+	_shared->x = x0;
+	_shared->y = y0;
+	_shared->block = view.Block();
+	_shared->dots = dots;
+	_shared->rows = rows;
+	if (!Command())
+	{
+		return false;
+	}
+
+	const int64_t total = Live();
+	const int live = static_cast<int>(std::min<int64_t>(total, std::numeric_limits<int>::max()));
+	frame.sample = Sample();
+	frame.sample.generation = _generation;
+	frame.sample.counts.live = live;
+	frame.sample.counts.dead = static_cast<int>(std::min<int64_t>((static_cast<int64_t>(_width) * _height) - total, std::numeric_limits<int>::max()));
+	_trend.push_back(live);
+	if (_trend.size() > Frame::TrendLength)
+	{
+		_trend.erase(_trend.begin());
+	}
+	frame.trend = _trend;
+	frame.activeRatio = 1.0;
+	frame.period = 0;
+
+	const uint8_t* out = _shared->Dots();
+	if (view.zoom == 0)
+	{
+		std::transform(out, out + frame.glyphs.size(), frame.glyphs.begin(), [](uint8_t dot)
+		{
+			return static_cast<uint8_t>(dot ? Cell::State::Live : Cell::State::Dead);
+		});
+		return true;
+	}
+
+	// 2x4 dots per character, the dot bits are in the order Unicode numbers braille dots
+	static constexpr uint8_t dotBits[4][2] = { { 0x01, 0x08 }, { 0x02, 0x10 }, { 0x04, 0x20 }, { 0x40, 0x80 } };
+	for (int y = 0; y < frame.height; y++)
+	{
+		for (int x = 0; x < frame.width; x++)
+		{
+			uint8_t glyph = 0;
+			for (int r = 0; r < 4; r++)
+			{
+				const uint8_t* dot = out + (static_cast<size_t>((y * 4) + r) * dots) + (x * 2);
+				glyph |= (dot[0] ? dotBits[r][0] : 0) | (dot[1] ? dotBits[r][1] : 0);
+			}
+			frame.glyphs[x + (y * frame.width)] = glyph;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,103 @@
+﻿#pragma once
+#include "BitBoard.h"
+#include "Frame.h"
+
+// one board split between several worker processes, each stepping its own stripe of rows with the Packed
+// engine's bit planes. every generation the stripes swap their top and bottom rows through rings in shared
+// memory and wait for each other on a barrier there, so the only thing that crosses between processes is
+// two rows a stripe. the process that started them just hands out commands and gathers what's on the screen
+// needs fork and POSIX shared memory, so it's Linux (or anything like it) only
+class Stripes
+{
+public:
+    // with the stripes as thin as a row there'd be nothing left to overlap the exchange with
+    static constexpr int MaxProcesses = 64;
+    // bytes of dots Capture can gather at once, a big terminal zoomed out is about a quarter of this
+    static constexpr size_t MaxDots = size_t{ 1 } << 20;
+
+    // the whole board, from all the stripes
+    struct Tally
+    {
+        int64_t live = 0;
+        // what Board::Hash would say
+        uint64_t hash = 0;
+    };
+
+private:
+    // the shared memory, see Stripes.cpp for what's in it
+    struct Shared;
+    Shared* _shared = nullptr;
+    size_t _bytes = 0;
+    // process ids, there's one for each stripe once Start is done
+    std::vector<int> _workers;
+    int _processes = 0;
+    int _width = 0;
+    int _height = 0;
+    Topology _topology = Topology::Torus;
+    PackedRule _rule{};
+    int64_t _generation = 0;
+    // population of the last captures, for the HUD's trend
+    std::vector<int> _trend;
+
+    Stripes() = default;
+
+    // the first row of stripe, the stripe ends where the next one starts
+    int StripeBegin(int stripe) const
+    {
+        return static_cast<int>((static_cast<int64_t>(_height) * stripe) / _processes);
+    }
+
+    // hands every worker the command in _shared and waits until they've all done it, false if one of them has gone
+    bool Command();
+
+    // adds up the stripes' live cells from the last Gather or Count
+    int64_t Live() const;
+
+    // false once a worker has exited
+    bool WorkersAlive();
+
+    // what a worker process runs until it's told to quit or the coordinator goes away
+    // fraction and seed fill the stripe the way Board::Fill would
+    void Work(int stripe, int parent, uint32_t fraction, uint64_t seed);
+
+public:
+    Stripes(const Stripes&) = delete;
+    Stripes const& operator=(const Stripes&) = delete;
+
+    // tells the workers to quit and waits for them
+    ~Stripes();
+
+    // starts processes workers on a width x height board that's live with probability density, the same cells
+    // Board::Fill(density, seed) makes. nullptr, after saying why, if that couldn't be done
+    static std::unique_ptr<Stripes> Start(int width, int height, int processes, Topology topology, PackedRule rule, double density, uint64_t seed);
+
+    int Width() const
+    {
+        return _width;
+    }
+
+    int Height() const
+    {
+        return _height;
+    }
+
+    int Processes() const
+    {
+        return _processes;
+    }
+
+    int64_t Generation() const
+    {
+        return _generation;
+    }
+
+    // runs generations more generations, false if a worker has gone
+    bool Step(int64_t generations);
+
+    // population and hash of the whole board, the same ones a Board with these cells would give
+    // the hash goes through the stripes one after the other, so this is for the end of a run rather than every step
+    std::optional<Tally> Count();
+
+    // what Board::Capture does, the counts are only the live ones. false if a worker has gone
+    bool Capture(Frame& frame, const Viewport& view);
+};
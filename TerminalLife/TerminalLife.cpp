@@ -4,62 +4,229 @@
 #include "Board.h"
 #include "Cell.h"
 #include "hud.h"
+#include "Renderer.h"
+#include "Frame.h"
+#include "TripleBuffer.h"
+#include "FrameWriter.h"
+#include "Benchmark.h"
+#include "Checkpoint.h"
+#include "Profiler.h"
+#include "Stripes.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+    // no arguments sizes the board to the console, otherwise it's the same options as --bench
+    std::optional<Benchmark::Options> options;
+    if (argc > 1)
+    {
+        options = Benchmark::Parse(argc, argv);
+        if (!options)
+        {
+            Benchmark::PrintUsage();
+            return -1;
+        }
+    }
+
+    // headless, doesn't touch the console at all
+    if (Benchmark::Requested(argc, argv))
+    {
+        return Benchmark::Run(*options);
+    }
+
     ConsoleConfig console;
     HUD::PrintIntro();
     console.DrawBegin();
-    Board board(console.Width() / 2, console.Height() - 10);
-
-    // Randomly fill  spots for n 'generations'
-    int n = board.Width() * board.Height() / 4;
-    board.RandomizeBoard(n);
-    
-    // Rulesets
-    auto C = std::bind_front(&Board::ConwayRules, &board);
-    auto D = std::bind_front(&Board::DayAndNightRules, &board);
-    auto S = std::bind_front(&Board::SeedsRules, &board);
-    auto B = std::bind_front(&Board::BriansBrainRules, &board);
-    auto H = std::bind_front(&Board::HighlifeRules, &board);
-    auto L = std::bind_front(&Board::LifeWithoutDeathRules, &board);
+
+    // Rulesets, any other rulestring works too: const Rule Ruleset = *Rule::Parse("B36/S23");
+    [[maybe_unused]] constexpr Rules::Conway C;
+    [[maybe_unused]] constexpr Rules::DayAndNight D;
+    [[maybe_unused]] constexpr Rules::Seeds S;
+    [[maybe_unused]] constexpr Rules::BriansBrain B;
+    [[maybe_unused]] constexpr Rules::Highlife H;
+    [[maybe_unused]] constexpr Rules::LifeWithoutDeath L;
 
     // pick your Ruleset here
     auto const& Ruleset = C;
 
-    // simulation loop
-    while (true)
+    // --processes splits the board between worker processes and this one only draws it, the Board below just stands in
+    // they have to be forked before the Board starts any threads
+    std::unique_ptr<Stripes> stripes;
+    if (options && options->processes > 1)
+    {
+        stripes = Stripes::Start(options->width, options->height, options->processes, options->topology, Ruleset.Packed(), options->density, options->seed);
+        if (!stripes)
+        {
+            return -1;
+        }
+    }
+
+    // pick your engine here, Packed is much faster and smaller but only runs plain B/S rules
+    // HashLife runs plain B/S rules on an unbounded plane, SetStepSize(n) makes each step 2^n generations
+    // Incremental runs anything and only looks at cells next to the last changes, best for long quiet runs
+    // Sparse runs plain B/S rules on an unbounded plane too, one generation a step, and only pays for where there's life
+    // boards bigger than the console get drawn zoomed out, the arrows and [<] [>] move around
+    const Board::Engine engine = options ? options->engine : Board::Engine::Cells;
+    const int columns = console.Width();
+    const int rows = console.Height() - 10;
+    Board board(stripes ? 1 : options ? options->width : columns / 2, stripes ? 1 : options ? options->height : rows, engine);
+    board.SetThreads(stripes ? 1 : options ? options->threads : static_cast<int>(std::thread::hardware_concurrency()));
+    if (options)
     {
-        console.SetPositionHome();
-        if (!HUD::Update(board))
-            break;
+        board.SetBlockSize(options->blockWidth, options->blockHeight);
+        board.SetStepSize(options->step);
+    }
+    HUD::SetView(stripes ? stripes->Width() : board.Width(), stripes ? stripes->Height() : board.Height(), columns, rows);
 
-        // print the board to the console AND flush the stream
-        console.SetPositionBoard();
-        board.PrintBoard();
+    // the HUD draws the population trend from the history, --history keeps more and writes it out at the end
+    board.KeepHistory(std::max(Frame::TrendLength, options ? Benchmark::HistoryLength(*options) : 0));
+
+    // a quarter of the board live, pass --seed to get the same board again. the stripes fill themselves
+    if (options && !stripes)
+    {
+        if (!Benchmark::Seed(board, *options))
+        {
+            return -1;
+        }
+        board.Advance(Ruleset, options->jump);
+        HUD::SetOldAge(Cell::GetOldAge());
+    }
+    else if (!options)
+    {
+        std::random_device rd;
+        board.Fill(0.25, (static_cast<uint64_t>(rd()) << 32) | rd());
+    }
 
-        HUD::HandleIncremental();
+    // --trace times every phase from here on, [P] only turns the timers on while the HUD shows them
+    if (options && !options->trace.empty())
+    {
+        Profiler::StartTrace(Benchmark::TraceEvents);
+        HUD::SetTracing(true);
+    }
 
-        // TODO this is bad
-        Cell::SetOldAge(HUD::OldAge());
+    // the board goes under the HUD, on the row ConsoleConfig::SetPositionBoard uses
+    Renderer renderer(5);
+    FrameWriter writer;
 
-        board.UpdateBoard(Ruleset);
+    // the simulation thread publishes every generation here, the render thread only draws the newest
+    TripleBuffer<Frame> frames;
 
-        // this will show the user the pending changes to the board (born, dying, etc.)
-        if (HUD::Fate())
+    // --checkpoint saves the board every so often from its own thread
+    std::unique_ptr<Checkpointer> checkpointer;
+    if (options && !options->checkpoint.empty())
+    {
+        checkpointer = std::make_unique<Checkpointer>(options->checkpoint, options->checkpointEvery, Ruleset.ToString(), board.Generation());
+    }
+
+    // simulation loop, runs as fast as it can and never waits on the console
+    bool workerLost = false;
+    std::thread simulation([&board, &frames, &Ruleset, &checkpointer, &stripes, &workerLost]()
+    {
+        const auto publish = [&board, &frames, &stripes, &workerLost]()
+        {
+            ProfileScope scope(Profiler::Phase::Capture);
+            if (stripes)
+            {
+                workerLost = !stripes->Capture(frames.Back(), HUD::View());
+            }
+            else
+            {
+                board.Capture(frames.Back(), HUD::View());
+            }
+            frames.Publish();
+        };
+
+        publish();
+        while (!HUD::Quitting() && !workerLost)
         {
-            console.SetPositionHome();
-            HUD::Update(board);
+            {
+                // paused or single stepping waits in here
+                ProfileScope scope(Profiler::Phase::Sleep);
+                HUD::HandleIncremental();
+            }
 
-            // print the board with Fates to the console AND flush the stream
-            console.SetPositionBoard();
-            board.PrintBoard();
+            // the workers do the rule and the commit in one go, and there's nothing pending to show in between
+            if (stripes)
+            {
+                {
+                    ProfileScope scope(Profiler::Phase::Rule);
+                    workerLost = !stripes->Step(1);
+                }
+                publish();
+                continue;
+            }
 
-            HUD::HandleIncremental();
+            // TODO this is bad
+            Cell::SetOldAge(HUD::OldAge());
+
+            {
+                ProfileScope scope(Profiler::Phase::Rule);
+                board.UpdateBoard(Ruleset);
+            }
+
+            // this will show the user the pending changes to the board (born, dying, etc.)
+            if (HUD::Fate())
+            {
+                publish();
+                HUD::HandleIncremental();
+            }
+
+            // this applies the changes that were determined by the ruleset called by Board::UpdateBoard();
+            {
+                ProfileScope scope(Profiler::Phase::Commit);
+                board.NextGeneration();
+            }
+            if (checkpointer)
+            {
+                checkpointer->Offer(board);
+            }
+            publish();
         }
+    });
 
-        // this applies the changes that were determined by the ruleset called by Board::UpdateBoard();
-        board.NextGeneration();
+    // render loop, draws the newest generation at up to FramesPerSecond and skips the ones in between
+    constexpr int FramesPerSecond = 60;
+    constexpr auto frameTime = std::chrono::microseconds(1000000 / FramesPerSecond);
+    auto nextFrame = std::chrono::steady_clock::now();
+    while (HUD::CheckKeyState())
+    {
+        if (frames.Acquire())
+        {
+            // HUD and board go out together in one write
+            const Frame& frame = frames.Front();
+            {
+                ProfileScope scope(Profiler::Phase::Draw);
+                writer.Begin(frame.width, frame.height);
+                HUD::Update(frame, writer);
+                renderer.Present(frame, writer);
+            }
+            ProfileScope scope(Profiler::Phase::Write);
+            writer.Flush();
+        }
+
+        // don't try to catch up on frames we were too slow for
+        nextFrame = std::max(nextFrame + frameTime, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    HUD::Quit();
+    simulation.join();
+
+    if (workerLost)
+    {
+        console.Clear();
+        std::cout << "\x1b[mTerminalLife: a worker process went away" << std::endl;
+        return -1;
+    }
+
+    // the last checkpoint is wherever the run stopped
+    if (checkpointer)
+    {
+        checkpointer->Finish(board);
+    }
+
+    if (options && !Benchmark::Save(board, Ruleset.ToString(), *options))
+    {
+        return -1;
     }
 
     console.Clear();
@@ -0,0 +1,165 @@
+﻿#include "pch.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	uint64_t Pack(uint32_t begin, uint32_t end)
+	{
+		return (static_cast<uint64_t>(begin) << 32) | end;
+	}
+}
+
+ThreadPool::ThreadPool(int threads)
+	: _queues(std::max(threads, 1))
+{
+	for (int i = 1; i < threads; i++)
+	{
+		_threads.emplace_back([this, i]() { Worker(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+
+	for (std::thread& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Worker(int index)
+{
+	uint64_t seen = 0;
+	std::unique_lock lock(_mutex);
+
+	while (true)
+	{
+		_wake.wait(lock, [&]() { return _quit || _jobId != seen; });
+		if (_quit)
+		{
+			return;
+		}
+
+		seen = _jobId;
+		const std::function<void(int)>& job = *_job;
+		lock.unlock();
+
+		job(index);
+
+		lock.lock();
+		if (--_pending == 0)
+		{
+			_done.notify_one();
+		}
+	}
+}
+
+void ThreadPool::Run(const std::function<void(int)>& job)
+{
+	if (_threads.empty())
+	{
+		job(0);
+		return;
+	}
+
+	{
+		std::scoped_lock lock(_mutex);
+		_job = &job;
+		_pending = static_cast<int>(_threads.size());
+		_jobId++;
+	}
+	_wake.notify_all();
+
+	job(0);
+
+	std::unique_lock lock(_mutex);
+	_done.wait(lock, [this]() { return _pending == 0; });
+}
+
+void ThreadPool::RunQueue(int worker, const std::function<void(int, int)>& task, std::chrono::steady_clock::time_point start)
+{
+	Queue& queue = _queues[worker];
+	const int workers = static_cast<int>(_queues.size());
+	while (true)
+	{
+		// the front of our own queue
+		uint64_t range = queue.range.load(std::memory_order_acquire);
+		uint32_t begin = static_cast<uint32_t>(range >> 32);
+		uint32_t end = static_cast<uint32_t>(range);
+		if (begin < end)
+		{
+			if (queue.range.compare_exchange_weak(range, Pack(begin + 1, end), std::memory_order_acq_rel))
+			{
+				task(worker, static_cast<int>(begin));
+				queue.stats.tasks++;
+			}
+			continue;
+		}
+
+		// out of work, take the back half of the next queue that has any
+		bool stole = false;
+		for (int other = (worker + 1) % workers; other != worker && !stole; other = (other + 1) % workers)
+		{
+			std::atomic<uint64_t>& victim = _queues[other].range;
+			range = victim.load(std::memory_order_acquire);
+			while (true)
+			{
+				begin = static_cast<uint32_t>(range >> 32);
+				end = static_cast<uint32_t>(range);
+				if (begin >= end)
+				{
+					break;
+				}
+
+				const uint32_t split = end - ((end - begin + 1) / 2);
+				if (victim.compare_exchange_weak(range, Pack(begin, split), std::memory_order_acq_rel))
+				{
+					// only we ever store to our own queue, and it was empty, so thieves will have left it alone
+					queue.stats.stolen += end - split;
+					queue.range.store(Pack(split, end), std::memory_order_release);
+					stole = true;
+					break;
+				}
+			}
+		}
+
+		if (!stole)
+		{
+			queue.stats.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			return;
+		}
+	}
+}
+
+void ThreadPool::RunTasks(int count, const std::function<void(int, int)>& task)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const int64_t workers = static_cast<int64_t>(_queues.size());
+	for (int64_t worker = 0; worker < workers; worker++)
+	{
+		const uint32_t begin = static_cast<uint32_t>((count * worker) / workers);
+		const uint32_t end = static_cast<uint32_t>((count * (worker + 1)) / workers);
+		_queues[worker].range.store(Pack(begin, end), std::memory_order_relaxed);
+	}
+
+	// Run's lock hands the queues over to the workers
+	Run([this, &task, start](int worker)
+	{
+		RunQueue(worker, task, start);
+	});
+	_elapsedNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ThreadPool::ResetStats()
+{
+	for (Queue& queue : _queues)
+	{
+		queue.stats = WorkerStats();
+	}
+	_elapsedNs = 0;
+}
@@ -0,0 +1,78 @@
+﻿#pragma once
+
+// a fixed set of worker threads that live as long as the pool
+// Run() hands the same job to every worker and returns once they have all finished it,
+// so back to back Run() calls are separated by a barrier
+// RunTasks() deals a list of tasks out between the workers and lets the ones that run out steal from the rest
+class ThreadPool
+{
+public:
+    // what one worker did across every RunTasks, so it's easy to see how evenly the work got spread
+    struct WorkerStats
+    {
+        int64_t tasks = 0;
+        // tasks it took off other workers, a steal takes half of what the other worker had left
+        int64_t stolen = 0;
+        // from the start of RunTasks until it ran out of tasks to run or steal
+        int64_t busyNs = 0;
+    };
+
+private:
+    // a worker's tasks that nobody has started yet, [begin, end) packed into one word as begin << 32 | end
+    // the worker takes them from the front, thieves take half from the back, each with one compare and swap
+    struct alignas(64) Queue
+    {
+        std::atomic<uint64_t> range = 0;
+        WorkerStats stats;
+    };
+
+    std::vector<Queue> _queues;
+    // wall time spent in RunTasks, what busyNs gets compared to
+    int64_t _elapsedNs = 0;
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(int)>* _job = nullptr;
+    uint64_t _jobId = 0;
+    int _pending = 0;
+    bool _quit = false;
+
+    void Worker(int index);
+
+    // runs tasks until worker's queue is empty and there's nothing left anywhere to steal
+    void RunQueue(int worker, const std::function<void(int, int)>& task, std::chrono::steady_clock::time_point start);
+
+public:
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool const& operator=(const ThreadPool&) = delete;
+
+    // threads counts the calling thread, which runs job(0) itself
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    int Size() const
+    {
+        return static_cast<int>(_threads.size()) + 1;
+    }
+
+    // calls job(index) once for every index in [0, Size()) and waits for all of them
+    void Run(const std::function<void(int)>& job);
+
+    // calls task(worker, index) once for every index in [0, count) and waits for all of them
+    // each worker starts out with an even run of indexes, so neighboring tasks tend to stay on one thread
+    void RunTasks(int count, const std::function<void(int, int)>& task);
+
+    WorkerStats Stats(int worker) const
+    {
+        return _queues[worker].stats;
+    }
+
+    int64_t ElapsedNs() const
+    {
+        return _elapsedNs;
+    }
+
+    void ResetStats();
+};
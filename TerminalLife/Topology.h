@@ -0,0 +1,36 @@
+﻿#pragma once
+
+// what's past the edges of a board
+// Torus wraps left to right and top to bottom, Cylinder only left to right, Bounded is dead all the way around,
+// and Klein wraps both ways but whatever goes off the top or bottom comes back on the other side mirrored
+enum class Topology { Torus, Bounded, Cylinder, Klein };
+
+// moves (x, y) from anywhere around a width x height board to the cell it really is, false if it's off the edge and dead
+inline bool WrapCell(Topology topology, int width, int height, int& x, int& y)
+{
+    if (y < 0 || y >= height)
+    {
+        if (topology != Topology::Torus && topology != Topology::Klein)
+        {
+            return false;
+        }
+
+        // every trip over the top or bottom of a Klein bottle flips it left to right
+        const int turns = (y >= 0) ? (y / height) : -((height - 1 - y) / height);
+        y -= turns * height;
+        if (topology == Topology::Klein && (turns & 1))
+        {
+            x = width - 1 - x;
+        }
+    }
+
+    if (x < 0 || x >= width)
+    {
+        if (topology == Topology::Bounded)
+        {
+            return false;
+        }
+        x = ((x % width) + width) % width;
+    }
+    return true;
+}
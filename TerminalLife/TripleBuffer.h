@@ -0,0 +1,49 @@
+﻿#pragma once
+
+// hands the newest T from one producer thread to one consumer thread without locks or waiting
+// the producer fills Back() and calls Publish(), the consumer calls Acquire() and reads Front()
+// whatever gets published while the consumer is busy replaces what it hasn't picked up yet
+template <typename T>
+class TripleBuffer
+{
+private:
+    // set on the middle slot when it holds something the consumer hasn't seen
+    static constexpr uint8_t Fresh = 4;
+
+    T _slots[3];
+    std::atomic<uint8_t> _middle{ 1 };
+    // only ever touched by their own thread
+    uint8_t _back = 0;
+    uint8_t _front = 2;
+
+public:
+    T& Back()
+    {
+        return _slots[_back];
+    }
+
+    // swaps the filled back slot into the middle and takes whatever was there to fill next
+    void Publish()
+    {
+        const uint8_t middle = _middle.exchange(_back | Fresh, std::memory_order_acq_rel);
+        _back = middle & 3;
+    }
+
+    // false if nothing new was published since the last call, Front() stays the same
+    bool Acquire()
+    {
+        if (!(_middle.load(std::memory_order_relaxed) & Fresh))
+        {
+            return false;
+        }
+
+        const uint8_t middle = _middle.exchange(_front, std::memory_order_acq_rel);
+        _front = middle & 3;
+        return true;
+    }
+
+    const T& Front() const
+    {
+        return _slots[_front];
+    }
+};
@@ -0,0 +1,20 @@
+﻿#pragma once
+#include "SplitMix.h"
+
+// Zobrist hashing of a whole board: the hash is the XOR of a key for every cell that isn't dead, so when
+// a cell changes the hash changes by Key(cell, before) ^ Key(cell, after) and nobody has to look at the rest
+// the keys only depend on the cell index and state, so every engine hashes the same board the same
+namespace Zobrist
+{
+    // dead cells are 0 so empty space doesn't cost anything, states go up to Rule::MaxStates
+    constexpr uint64_t Key(uint64_t cell, uint8_t state)
+    {
+        return state ? SplitMix::At(0x5a0b215700000000, (cell << 6) | state) : 0;
+    }
+
+    // what the hash changes by when cell goes from before to after
+    constexpr uint64_t Change(uint64_t cell, uint8_t before, uint8_t after)
+    {
+        return (before == after) ? 0 : Key(cell, before) ^ Key(cell, after);
+    }
+}
@@ -1,78 +1,257 @@
 ﻿#include "pch.h"
 #include "hud.h"
-#include "Board.h"
+#include "ConsoleConfig.h"
+#include "Frame.h"
+#include "FrameWriter.h"
+#include "Profiler.h"
 
 bool HUD::CheckKeyStateImpl ()
 {
-	if (GetAsyncKeyState(VK_ESCAPE) & 0x01)
+	for (ConsoleConfig::Key key = ConsoleConfig::ReadKey(); key != ConsoleConfig::Key::None; key = ConsoleConfig::ReadKey())
 	{
-		return false;
+		switch (key)
+		{
+		case ConsoleConfig::Key::Escape:
+			return false;
+
+		case ConsoleConfig::Key::Plus:
+			_msSleep += 100;
+			break;
+
+		case ConsoleConfig::Key::F1:
+			_fOldAge = !_fOldAge;
+			break;
+
+		case ConsoleConfig::Key::Minus:
+			_msSleep -= 100;
+			if (_msSleep < 1) _msSleep = 0;
+			break;
+
+		case ConsoleConfig::Key::F:
+			_fFate = !_fFate;
+			break;
+
+		case ConsoleConfig::Key::S:
+			_fScore = !_fScore;
+			break;
+
+		case ConsoleConfig::Key::P:
+			// the timers only run while somebody's looking, or a trace was asked for
+			_fProfile = !_fProfile;
+			Profiler::Enable(_fProfile || _fTrace);
+			break;
+
+		case ConsoleConfig::Key::I:
+			_fIncremental = !_fIncremental;
+
+			// don't leave the simulation waiting for a SPACE that isn't needed anymore
+			if (!_fIncremental)
+			{
+				_steps++;
+				_steps.notify_one();
+			}
+			break;
+
+		case ConsoleConfig::Key::Left:
+			Scroll(-1, 0);
+			break;
+
+		case ConsoleConfig::Key::Right:
+			Scroll(1, 0);
+			break;
+
+		case ConsoleConfig::Key::Up:
+			Scroll(0, -1);
+			break;
+
+		case ConsoleConfig::Key::Down:
+			Scroll(0, 1);
+			break;
+
+		case ConsoleConfig::Key::ZoomIn:
+			Zoom(-1);
+			break;
+
+		case ConsoleConfig::Key::ZoomOut:
+			Zoom(1);
+			break;
+
+		case ConsoleConfig::Key::Space:
+			if (_fIncremental)
+			{
+				_steps++;
+				_steps.notify_one();
+			}
+			break;
+
+		default:
+			break;
+		}
 	}
 
-	if (GetAsyncKeyState(VK_OEM_PLUS) & 0x01)
-		_msSleep += 100;
+	return true;
+}
 
-	if (GetAsyncKeyState(VK_F1) & 0x01)
-		_fOldAge = !_fOldAge;
+void HUD::SetViewImpl(int boardWidth, int boardHeight, int columns, int rows)
+{
+	_boardWidth = boardWidth;
+	_boardHeight = boardHeight;
+	_columns = columns;
+	_rows = rows;
 
-	if (GetAsyncKeyState(VK_OEM_MINUS) & 0x01)
+	// start zoomed out far enough to see the whole board
+	_zoom = 0;
+	while (_zoom < 24)
 	{
-		_msSleep -= 100;
-		if (_msSleep < 1) _msSleep = 0;
+		const Viewport view = ViewImpl();
+		if (view.GlyphColumns() * view.GlyphWidth() >= _boardWidth && view.GlyphRows() * view.GlyphHeight() >= _boardHeight)
+		{
+			break;
+		}
+		_zoom++;
 	}
+	_maxZoom = _zoom;
+}
 
-	if (GetAsyncKeyState(0x46) & 0x01)
-		_fFate = !_fFate;
+Viewport HUD::ViewImpl() const
+{
+	Viewport view;
+	view.x = _viewX;
+	view.y = _viewY;
+	view.zoom = _zoom;
+	view.columns = _columns;
+	view.rows = _rows;
+	return view;
+}
 
-	if (GetAsyncKeyState(0x53) & 0x01)
-		_fScore = !_fScore;
+void HUD::Scroll(int dx, int dy)
+{
+	const Viewport view = ViewImpl();
+	const int width = view.GlyphColumns() * view.GlyphWidth();
+	const int height = view.GlyphRows() * view.GlyphHeight();
 
-	if (GetAsyncKeyState(0x49) & 0x01)
-		_fIncremental = !_fIncremental;
+	_viewX = std::clamp(view.x + (dx * std::max(width / 4, 1)), 0, std::max(_boardWidth - width, 0));
+	_viewY = std::clamp(view.y + (dy * std::max(height / 4, 1)), 0, std::max(_boardHeight - height, 0));
+}
 
-	return true;
+void HUD::Zoom(int dz)
+{
+	const Viewport view = ViewImpl();
+	const int zoom = std::clamp(view.zoom + dz, 0, _maxZoom);
+	if (zoom == view.zoom)
+	{
+		return;
+	}
+
+	// keep whatever was in the middle of the screen there
+	const int centerX = view.x + (view.GlyphColumns() * view.GlyphWidth() / 2);
+	const int centerY = view.y + (view.GlyphRows() * view.GlyphHeight() / 2);
+	_zoom = zoom;
+
+	const Viewport zoomed = ViewImpl();
+	_viewX = centerX - (zoomed.GlyphColumns() * zoomed.GlyphWidth() / 2);
+	_viewY = centerY - (zoomed.GlyphRows() * zoomed.GlyphHeight() / 2);
+	Scroll(0, 0);
 }
 
 void HUD::PrintIntroImpl() const 
 {
 	std::cout << "\x1b[mWelcome to TerminalLife\r\n\r\nResize your console to get the biggest simulation\r\n";
-	std::cout << "\x1b[mENTER to start\r\nSPACE to pause/unpause\r\nESC to quit\r\n[+] and [-] to change speed\r\n[S] to toggle the HUD\r\n[F] to show cell fates\r\n[I] to toggle incremental vs. continuous simulation" << std::endl;
+	std::cout << "\x1b[mENTER to start\r\nSPACE to pause/unpause\r\nESC to quit\r\n[+] and [-] to change speed\r\n[S] to toggle the HUD\r\n[F] to show cell fates\r\n[I] to toggle incremental vs. continuous simulation\r\n[P] to show how long each phase takes\r\nArrows to scroll, [<] and [>] to zoom out and in" << std::endl;
 	std::cin.get();
 }
 
-bool HUD::UpdateImpl(const Board& board) const
+void HUD::UpdateImpl(const Frame& frame, FrameWriter& out) const
 {
-	if (!HUD::CheckKeyState())
-		return false;
+	out.MoveTo(0, 0);
 
 	if (HUD::Score())
 	{
-		std::cout << "\x1b[mGeneration " << board.Generation() << ". Sleep: " << HUD::Delay() << ". Life Span: " << HUD::OldAge() << ". Alive: " << Cell::GetLiveCount() << ". Dead: " << Cell::GetDeadCount() << ". Born: " << Cell::GetBornCount() << ". Dying: " << Cell::GetDyingCount() << ". OldAge: " << Cell::GetOldCount() << ".\x1b[0K\n";
+		// the frame stats are from the last frame, this one isn't finished yet
+		const std::pair<std::string_view, int64_t> fields[] =
+		{
+			{ "\x1b[mGeneration ", frame.sample.generation },
+			{ ". Sleep: ", HUD::Delay() },
+			{ ". Life Span: ", HUD::OldAge() },
+			{ ". Alive: ", frame.sample.counts.live },
+			{ ". Dead: ", frame.sample.counts.dead },
+			{ ". Born: ", frame.sample.counts.born },
+			{ ". Dying: ", frame.sample.counts.dying },
+			{ ". OldAge: ", frame.sample.counts.old },
+			{ ". Box: ", frame.sample.bounds.Width() },
+			{ "x", frame.sample.bounds.Height() },
+			{ ". Active: ", static_cast<int64_t>(frame.activeRatio * 100.0) },
+			{ "%. Period: ", frame.period },
+			{ ". Zoom: ", frame.zoom },
+			{ ". Frame: ", static_cast<int64_t>(out.LastBytes()) },
+			{ " bytes, ", out.LastAllocations() },
+			{ " allocs, ", out.LastWrites() },
+		};
+
+		for (const auto& [label, value] : fields)
+		{
+			out.Append(label);
+			out.AppendNumber(value);
+		}
+		out.Append(" writes. ");
+
+		// population over the last few generations as U+2581 to U+2588, lowest to highest
+		static constexpr std::string_view bars[] = { "\xe2\x96\x81", "\xe2\x96\x82", "\xe2\x96\x83", "\xe2\x96\x84", "\xe2\x96\x85", "\xe2\x96\x86", "\xe2\x96\x87", "\xe2\x96\x88" };
+		const auto [low, high] = std::minmax_element(frame.trend.begin(), frame.trend.end());
+		for (const int live : frame.trend)
+		{
+			const int64_t range = *high - *low;
+			out.Append(bars[(range > 0) ? ((static_cast<int64_t>(live) - *low) * 7) / range : 0]);
+		}
+		out.Append("\x1b[0K\n");
 	}
-	else std::cout << "\x1b[2K\n";
+	else out.Append("\x1b[2K\n");
 
 	if (HUD::Incremental())
 	{
-		std::cout << "\x1b[mHit SPACE for next screen, [I] to continuously update\n\n";
+		out.Append("\x1b[mHit SPACE for next screen, [I] to continuously update\n\n");
 	}
-	else std::cout << "\x1b[2K\n";
+	else out.Append("\x1b[2K\n");
 
-	return true;
+	out.MoveTo(0, 2);
+	if (_fProfile)
+	{
+		// median and 99th percentile of every phase so far
+		out.Append("\x1b[mTimings p50/p99 us:");
+		for (int phase = 0; phase < static_cast<int>(Profiler::Phase::Count); phase++)
+		{
+			const Profiler::Summary summary = Profiler::Summarize(static_cast<Profiler::Phase>(phase));
+			out.Append(" ");
+			out.Append(Profiler::Name(static_cast<Profiler::Phase>(phase)));
+			out.Append(" ");
+			out.AppendNumber(static_cast<int64_t>(summary.p50Us));
+			out.Append("/");
+			out.AppendNumber(static_cast<int64_t>(summary.p99Us));
+			out.Append(".");
+		}
+		out.Append("\x1b[0K");
+	}
+	else out.Append("\x1b[2K");
 }
 
 
-void HUD::HandleIncrementalImpl() const
+void HUD::HandleIncrementalImpl()
 {
 	if (HUD::Incremental())
 	{
-		bool Paused = true;
-		while (Paused)
+		// the render thread counts the SPACE presses, sleep until there is one
+		while (_steps == 0)
 		{
-			if (GetAsyncKeyState(VK_SPACE) & 0x01)
-			{
-				Paused = false;
-			}
+			_steps.wait(0);
 		}
+		_steps--;
 	}
-	else Sleep(HUD::Delay());
+	else std::this_thread::sleep_for(std::chrono::milliseconds(HUD::Delay()));
+}
+
+void HUD::QuitImpl()
+{
+	_fQuit = true;
+	_steps++;
+	_steps.notify_one();
 }
@@ -1,5 +1,9 @@
 ﻿#pragma once
-extern class Board;
+#include "Frame.h"
+
+class FrameWriter;
+
+// keys are read on the render thread, the settings they change are read on the simulation thread
 
 class HUD
 {
@@ -40,6 +44,18 @@ public:
         return Get().OldAgeImpl();
     }
 
+    // a trace is running, see Profiler::StartTrace
+    static void SetTracing(bool tracing)
+    {
+        Get()._fTrace = tracing;
+    }
+
+    // turns the life span on if age is one, for a restored checkpoint
+    static void SetOldAge(int age)
+    {
+        Get()._fOldAge = age > 0;
+    }
+
     static bool CheckKeyState()
     {
         return Get().CheckKeyStateImpl();
@@ -50,30 +66,71 @@ public:
         Get().PrintIntroImpl();
     }
     
-    static bool Update(const Board& board)
+    // adds the HUD lines to the top of the frame being written
+    static void Update(const Frame& frame, FrameWriter& out)
     {
-        return Get().UpdateImpl(board);
+        Get().UpdateImpl(frame, out);
     }
 
+    // simulation thread, waits for SPACE in incremental mode or sleeps for the delay
     static void HandleIncremental()
     {
         Get().HandleIncrementalImpl();
     }
 
+    // lets the simulation thread out of HandleIncremental and tells it to stop
+    static void Quit()
+    {
+        Get().QuitImpl();
+    }
+
+    static bool Quitting()
+    {
+        return Get()._fQuit;
+    }
+
+    // what the arrow and zoom keys have to work with, call before anything reads View()
+    static void SetView(int boardWidth, int boardHeight, int columns, int rows)
+    {
+        Get().SetViewImpl(boardWidth, boardHeight, columns, rows);
+    }
+
+    // the part of the board to draw, the render thread moves it and the simulation thread captures it
+    static Viewport View()
+    {
+        return Get().ViewImpl();
+    }
+
 private:
 #ifdef _DEBUG
-    int _msSleep = 50;
-    bool _fFate = true;
-    bool _fScore = true;
-    bool _fIncremental = false;
-    bool _fOldAge = false;
+    std::atomic<int> _msSleep = 50;
+    std::atomic<bool> _fFate = true;
+    std::atomic<bool> _fScore = true;
+    std::atomic<bool> _fIncremental = false;
+    std::atomic<bool> _fOldAge = false;
 #else
-    int _msSleep = 0;
-    bool _fFate = false;
-    bool _fScore = true;
-    bool _fIncremental = false;
-    bool _fOldAge = false;
+    std::atomic<int> _msSleep = 0;
+    std::atomic<bool> _fFate = false;
+    std::atomic<bool> _fScore = true;
+    std::atomic<bool> _fIncremental = false;
+    std::atomic<bool> _fOldAge = false;
 #endif
+    std::atomic<bool> _fQuit = false;
+    std::atomic<bool> _fProfile = false;
+    // a trace is being kept, so the profiler stays on when the HUD line goes off
+    bool _fTrace = false;
+    // SPACE presses the simulation thread hasn't used up yet
+    std::atomic<int> _steps = 0;
+
+    std::atomic<int> _viewX = 0;
+    std::atomic<int> _viewY = 0;
+    std::atomic<int> _zoom = 0;
+    int _boardWidth = 0;
+    int _boardHeight = 0;
+    int _columns = 0;
+    int _rows = 0;
+    // zoomed out this far the whole board fits, there's no point going further
+    int _maxZoom = 0;
 
     int OldAgeImpl() const
     {
@@ -85,6 +142,12 @@ private:
 
     bool CheckKeyStateImpl();
     void PrintIntroImpl() const;
-    bool UpdateImpl(const Board& board) const;
-    void HandleIncrementalImpl() const;
+    void UpdateImpl(const Frame& frame, FrameWriter& out) const;
+    void HandleIncrementalImpl();
+    void QuitImpl();
+    void SetViewImpl(int boardWidth, int boardHeight, int columns, int rows);
+    Viewport ViewImpl() const;
+    // moves the view by a quarter screen per step, or zooms around the middle of it
+    void Scroll(int dx, int dy);
+    void Zoom(int dz);
 };
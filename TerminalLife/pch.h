@@ -1,9 +1,54 @@
 ﻿#pragma once
+#ifdef _WIN32
+// std::min and std::max, not the macros
+#define NOMINMAX
 #include <windows.h>
+#include <conio.h>
+#else
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 #include <string>
 #include <iostream>
-#include <conio.h>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
 #include <functional>
 #include <algorithm>
 #include <random>
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include <limits>
+#include <cstdint>
+#include <bit>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cerrno>